@@ -0,0 +1,21 @@
+#ifndef COPY_COUNTER_H
+#define COPY_COUNTER_H
+
+#include <atomic>
+#include <cstddef>
+
+// 批量路径（读写缓冲、位流拼接和整段复制）在用户态复制的字节数，每块累加一次，不在逐字节的路径上。
+// 分配计数看不到复制进已有缓冲或映射的数据，缓冲预算测试用它检查整份数据没有被多复制；
+// 计数器为进程全局，统计期间不要并发转换
+namespace CopyCounter
+{
+    inline std::atomic<unsigned long long> &bytes()
+    {
+        static std::atomic<unsigned long long> counter(0);
+        return counter;
+    }
+
+    inline void add(size_t size) { bytes().fetch_add(size, std::memory_order_relaxed); }
+}
+
+#endif // COPY_COUNTER_H
@@ -30,7 +30,7 @@ protected:
     // 将文件流设为protected以便子类访问
     std::ifstream file_in_stream;
     std::ofstream file_out_stream;
-    std::unordered_map<std::string, int> header;
+    const FileFormat *format; // 按扩展名查到的文件格式，不支持的格式为nullptr
     FileMode mode;
 
 public:
@@ -48,9 +48,9 @@ public:
 
     const std::string &getFileName() const { return filename; }
 
-    // 获取文件头信息
-    const std::unordered_map<std::string, int> &getHeader() const {
-        return header;
+    // 获取文件格式（字段表和文件头大小）
+    const FileFormat *getFormat() const {
+        return format;
     }
 
     File(std::string filename) : filename(filename)
@@ -58,7 +58,7 @@ public:
         systemBits = GET_SYSTEM_BITS();
         isLittleEndian = IS_LITTLE_ENDIAN;
         isBigEndian = IS_BIG_ENDIAN;
-        header = get_file_format(filename);
+        format = find_file_format(filename);
     }
 
     File(std::string filename, FileMode mode):File(filename){
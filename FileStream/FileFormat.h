@@ -2,9 +2,13 @@
 #define FILEFORMAT_H
 #include <string_view>
 #include <unordered_map>
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
+#include "sysdetect.h"
 
 // 统一的类型定义，确保所有模块使用一致的数据类型
 typedef uint8_t  u8;
@@ -29,10 +33,46 @@ struct FileFormat
     std::string_view suffix_name;
     const FileHeaderField* fields;
     size_t field_count;
+    size_t header_size; // 定长字段的总字节数
 };
 
+// 定长字段（size>0）的总字节数，即文件头大小
+constexpr size_t header_size(const FileHeaderField *fields, size_t count) {
+    size_t size = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (fields[i].size > 0) {
+            size += fields[i].size;
+        }
+    }
+    return size;
+}
+
+// 字段在文件头中的偏移，字段不存在或为变长字段时返回-1
+constexpr size_t field_offset(const FileHeaderField *fields, size_t count, std::string_view name) {
+    size_t offset = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (fields[i].name == name) {
+            return fields[i].size > 0 ? offset : static_cast<size_t>(-1);
+        }
+        if (fields[i].size > 0) {
+            offset += fields[i].size;
+        }
+    }
+    return static_cast<size_t>(-1);
+}
+
+constexpr int field_size(const FileHeaderField *fields, size_t count, std::string_view name) {
+    for (size_t i = 0; i < count; ++i) {
+        if (fields[i].name == name) {
+            return fields[i].size;
+        }
+    }
+    return 0;
+}
+
+// 字段表为inline变量，各编译单元共用同一份，文件头结构体按表的地址识别所属格式
 // BMP格式定义
-constexpr FileHeaderField bmp_fields[] = {
+inline constexpr FileHeaderField bmp_fields[] = {
     {"bfType", 2},            // 位图文件类型 ('BM')
     {"bfSize", 4},            // 位图文件大小
     {"bfReserved1", 2},       // 保留字，必须为0
@@ -53,10 +93,13 @@ constexpr FileHeaderField bmp_fields[] = {
 };
 
 // HUF格式定义
-constexpr FileHeaderField huf_fields[] = {
+inline constexpr FileHeaderField huf_fields[] = {
     {"hufType", 2},         // HUF文件类型 ('UF')
     {"fileSize", 4},        // 文件大小
-    {"reserved", 4},        // 保留
+    {"coder", 1},           // 熵编码后端（见HufCoder）
+    {"coderParam", 1},      // 编码后端参数（tANS为表大小的log2）
+    {"symbolBits", 1},      // 符号位宽（4/8/16，旧文件为0表示8）
+    {"level", 1},           // 压缩级别（1-9，0为未按级别压缩），仅作记录
     {"keySize", 1},         // 键大小（1-8）
     {"valueSize", 1},       // 值大小（1-8）
     {"keyNum", 4},          // 键数量
@@ -67,55 +110,165 @@ constexpr FileHeaderField huf_fields[] = {
 
 };
 
-constexpr const FileFormat file_format_list[] = {
-    {".bmp", bmp_fields, sizeof(bmp_fields)/sizeof(bmp_fields[0])},
-    {".huf", huf_fields, sizeof(huf_fields)/sizeof(huf_fields[0])}
+// 文件头结构体，成员与字段表一一对应，按文件中的字节排布紧凑存放（小端序）。
+// 偏移和大小由下方的static_assert与字段表在编译期核对，改动字段表时必须同步修改
+#pragma pack(push, 1)
+struct BmpHeader {
+    static constexpr const FileHeaderField *fields = bmp_fields;
+    static constexpr size_t field_count = sizeof(bmp_fields) / sizeof(bmp_fields[0]);
+
+    u16 bfType;
+    u32 bfSize;
+    u16 bfReserved1;
+    u16 bfReserved2;
+    u32 bfOffBits;
+    u32 biSize;
+    s32 biWidth;
+    s32 biHeight;
+    u16 biPlanes;
+    u16 biBitCount;
+    u32 biCompression;
+    u32 biSizeImage;
+    s32 biXPelsPerMeter;
+    s32 biYPelsPerMeter;
+    u32 biClrUsed;
+    u32 biClrImportant;
 };
 
-// 获取文件格式信息的函数
-static inline const std::unordered_map<std::string, int> get_file_format(const std::string& filename) {
-  // 查找文件扩展名
+struct HufHeader {
+    static constexpr const FileHeaderField *fields = huf_fields;
+    static constexpr size_t field_count = sizeof(huf_fields) / sizeof(huf_fields[0]);
+
+    u16 hufType;
+    u32 fileSize;
+    u8 coder;
+    u8 coderParam;
+    u8 symbolBits;
+    u8 level;
+    u8 keySize;
+    u8 valueSize;
+    u32 keyNum;
+    u64 bitNum;
+    u64 bitsetSize;
+};
+#pragma pack(pop)
+
+#define HEADER_FIELD_CHECK(Header, member) \
+    static_assert(offsetof(Header, member) == field_offset(Header::fields, Header::field_count, #member) && \
+                  sizeof(Header::member) == field_size(Header::fields, Header::field_count, #member), \
+                  #Header "::" #member " does not match the field table")
+
+static_assert(sizeof(BmpHeader) == header_size(bmp_fields, BmpHeader::field_count), "BmpHeader size does not match bmp_fields");
+HEADER_FIELD_CHECK(BmpHeader, bfType);
+HEADER_FIELD_CHECK(BmpHeader, bfSize);
+HEADER_FIELD_CHECK(BmpHeader, bfReserved1);
+HEADER_FIELD_CHECK(BmpHeader, bfReserved2);
+HEADER_FIELD_CHECK(BmpHeader, bfOffBits);
+HEADER_FIELD_CHECK(BmpHeader, biSize);
+HEADER_FIELD_CHECK(BmpHeader, biWidth);
+HEADER_FIELD_CHECK(BmpHeader, biHeight);
+HEADER_FIELD_CHECK(BmpHeader, biPlanes);
+HEADER_FIELD_CHECK(BmpHeader, biBitCount);
+HEADER_FIELD_CHECK(BmpHeader, biCompression);
+HEADER_FIELD_CHECK(BmpHeader, biSizeImage);
+HEADER_FIELD_CHECK(BmpHeader, biXPelsPerMeter);
+HEADER_FIELD_CHECK(BmpHeader, biYPelsPerMeter);
+HEADER_FIELD_CHECK(BmpHeader, biClrUsed);
+HEADER_FIELD_CHECK(BmpHeader, biClrImportant);
+
+static_assert(sizeof(HufHeader) == header_size(huf_fields, HufHeader::field_count), "HufHeader size does not match huf_fields");
+HEADER_FIELD_CHECK(HufHeader, hufType);
+HEADER_FIELD_CHECK(HufHeader, fileSize);
+HEADER_FIELD_CHECK(HufHeader, coder);
+HEADER_FIELD_CHECK(HufHeader, coderParam);
+HEADER_FIELD_CHECK(HufHeader, symbolBits);
+HEADER_FIELD_CHECK(HufHeader, level);
+HEADER_FIELD_CHECK(HufHeader, keySize);
+HEADER_FIELD_CHECK(HufHeader, valueSize);
+HEADER_FIELD_CHECK(HufHeader, keyNum);
+HEADER_FIELD_CHECK(HufHeader, bitNum);
+HEADER_FIELD_CHECK(HufHeader, bitsetSize);
+
+// 按字段表就地交换文件头中每个定长字段的字节序，文件按小端序存储，只在大端系统上需要
+inline void swap_header_fields(u8 *bytes, const FileHeaderField *fields, size_t count) {
+    size_t offset = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (fields[i].size > 0) {
+            std::reverse(bytes + offset, bytes + offset + fields[i].size);
+            offset += fields[i].size;
+        }
+    }
+}
+
+// 从文件开头的字节解出文件头：整块复制，大端系统上再统一交换字节序
+template <typename Header>
+inline Header decode_header(const u8 *bytes) {
+    Header header;
+    std::memcpy(&header, bytes, sizeof(Header));
+    if (IS_BIG_ENDIAN) {
+        swap_header_fields(reinterpret_cast<u8 *>(&header), Header::fields, Header::field_count);
+    }
+    return header;
+}
+
+// 把文件头按文件中的字节排布写入bytes（sizeof(Header)字节）
+template <typename Header>
+inline void encode_header(const Header &header, u8 *bytes) {
+    std::memcpy(bytes, &header, sizeof(Header));
+    if (IS_BIG_ENDIAN) {
+        swap_header_fields(bytes, Header::fields, Header::field_count);
+    }
+}
+
+// HUF文件使用的熵编码后端，写入头部coder字段
+// 旧文件该字段为保留的0，因此HUFFMAN必须保持为0
+enum class HufCoder : u8 {
+    HUFFMAN = 0,    // 静态哈夫曼树（BitStream）
+    TANS = 1,       // 表驱动ANS（TansCoder）
+    RICE = 2,       // 预测残差的自适应Golomb-Rice编码（RiceCoder），无码表
+    ADAPTIVE = 3,   // 单遍自适应哈夫曼（AdaptiveHuffman），coderParam为重建间隔的log2
+    CONTEXT = 4,    // 按相邻像素分桶的上下文哈夫曼（ContextHuffman），coderParam为上下文位数，键为(上下文<<8)|符号
+    PIXEL = 5,      // 24/32位图像的整像素哈夫曼（PixelHuffman），高频像素各占一个符号，其余按字节逃逸
+    DELTA = 6,      // 参考帧差分：残差 = 当前 - 参考（逐字节模256），再按字节静态哈夫曼编码；位集开头为16字节参考描述
+    BLOCK = 7,      // 自适应分块哈夫曼（BlockHuffman），coderParam为共享码表数，键为(码表<<8)|符号，位集开头为块目录
+    PRETRAINED = 8, // 预训练静态哈夫曼（PretrainedTables），coderParam为码表编号，不保存频数表
+    STORED = 9,     // 不压缩，位集即原始数据
+    SEGMENTED = 10, // 分段静态哈夫曼（SegmentedHuffman），coderParam为码表数，键为(码表<<8)|符号，位集开头为段目录
+};
+
+inline constexpr FileFormat file_format_list[] = {
+    {".bmp", BmpHeader::fields, BmpHeader::field_count, sizeof(BmpHeader)},
+    {".huf", HufHeader::fields, HufHeader::field_count, sizeof(HufHeader)}
+};
+
+// 按文件扩展名查找格式，不支持时返回nullptr
+static inline const FileFormat *find_file_format(const std::string& filename) {
   size_t dot_pos = filename.find_last_of('.');
   if (dot_pos == std::string::npos) {
-      return std::unordered_map<std::string, int>();
+      return nullptr;
   }
-  
-  std::string suffix = filename.substr(dot_pos);
-  
-  // 查找匹配的文件格式
+
+  std::string_view suffix = std::string_view(filename).substr(dot_pos);
   for (const auto& file_format : file_format_list) {
     if (file_format.suffix_name == suffix) {
-      // 创建映射，忽略无效条目（键为空或值为0的条目）
-      std::unordered_map<std::string, int> format_map;
-      for(size_t i = 0; i < file_format.field_count; ++i) {
-          const auto& field = file_format.fields[i];
-          if (!field.name.empty() && field.size != 0) {
-              format_map[std::string(field.name)] = field.size;
-          }
-      }
-      return format_map;
+      return &file_format;
     }
   }
-  
-  return std::unordered_map<std::string, int>();
+  return nullptr;
 }
 
-// 检查文件是否为支持的格式
-static inline bool is_supported_format(const std::string& filename) {
-  size_t dot_pos = filename.find_last_of('.');
-  if (dot_pos == std::string::npos) {
-      return false;
-  }
-  
-  std::string suffix = filename.substr(dot_pos);
-  
+// 各格式中最大的文件头字节数
+constexpr size_t max_header_size() {
+  size_t size = 0;
   for (const auto& file_format : file_format_list) {
-    if (file_format.suffix_name == suffix) {
-      return true;
-    }
+    size = std::max(size, file_format.header_size);
   }
-  
-  return false;
+  return size;
+}
+
+// 检查文件是否为支持的格式
+static inline bool is_supported_format(const std::string& filename) {
+  return find_file_format(filename) != nullptr;
 }
 
 // 获取支持的文件扩展名列表
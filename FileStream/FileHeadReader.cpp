@@ -1,19 +1,14 @@
 #include "FileHeadReader.h"
 
 FileHeadReader::FileHeadReader(const std::string& filename) 
-    : FileReader(filename), filename(filename) {
-    m_header_format = get_file_format(filename);
-    
-    // 计算头部大小
-    m_head_size = 0;
-    for (const auto& field : m_header_format) {
-        if (field.second > 0) {  // 忽略大小为-1的字段（如数据字段）
-            m_head_size += field.second;
-        }
+    : FileReader(filename), filename(filename), m_format(file.getFormat()), m_head_size(0), m_is_header_read(false) {
+    // 头部大小在编译期由字段表算出
+    if (m_format != nullptr) {
+        m_head_size = static_cast<int>(m_format->header_size);
     }
-    
+
     // 读取完整的头部
-    header = readCompleteHeader();
+    readCompleteHeader();
 }
 
 FileHeadReader::~FileHeadReader() {
@@ -21,12 +16,8 @@ FileHeadReader::~FileHeadReader() {
 }
 
 bool FileHeadReader::toDataHeader() {
-
-    if(m_is_header_read == true)
-        reset();
-    
-    // 移动到数据部分，即跳过头部
-    file.getInputStream().seekg(m_head_size, std::ios::beg);
+    // 移动到数据部分，即跳过头部；头部读入时已填充读缓冲，这里只移动缓冲内的位置
+    seek(m_head_size);
     m_is_header_read = true;
     return true;
 }
@@ -35,75 +26,22 @@ int FileHeadReader::getHeadSize() {
     return m_head_size;
 }
 
-std::unordered_map<std::string, u64> FileHeadReader::getHeader() {
-    return header;
-}
-
 size_t FileHeadReader::getFileSize() {
     return file.getFileSize();
 }
 
 
-std::unordered_map<std::string, u64> FileHeadReader::readCompleteHeader() {
-        
-    if(m_is_header_read == true){
-       reset();
-       m_is_header_read = false;
-    }
-
-    std::unordered_map<std::string, u64> headerValues;
-    
-    // 重置到文件开始
-    file.getInputStream().seekg(0, std::ios::beg);
-    
-    // 根据文件格式读取各个字段
-    for (const auto& format : file_format_list) {
-        if (format.suffix_name == filename.substr(filename.find_last_of('.'))) {
-            for (size_t i = 0; i < format.field_count; ++i) {
-                const auto& field = format.fields[i];
-                
-                if (field.size > 0) {
-                    // 根据字段大小读取相应字节数
-                    switch (field.size) {
-                        case 1:
-                            headerValues[std::string(field.name)] = readu8();
-                            break;
-                        case 2:
-                            headerValues[std::string(field.name)] = readu16();
-                            break;
-                        case 4:
-                            headerValues[std::string(field.name)] = readu32();
-                            break;
-                        case 8:
-                            headerValues[std::string(field.name)] = readu64();
-                            break;
-                        default:
-                            // 对于其他大小，逐字节读取
-                            u64 value = 0;
-                            for (int j = 0; j < field.size; ++j) {
-                                value |= (static_cast<u64>(readu8()) << (j * 8));
-                            }
-                            headerValues[std::string(field.name)] = value;
-                            break;
-                    }
-                } else if (field.size == -1) {
-                    // -1表示变长字段，如数据部分，不在此处读取
-                    headerValues[std::string(field.name)] = 0;
-                }
-            }
-            break;
-        }
-    }
+void FileHeadReader::readCompleteHeader() {
+    // 文件头整块读入，各字段在取用时按结构体一次解出，不逐字段读取
+    readBlock(m_header_bytes.data(), m_head_size);
     m_is_header_read = true;
-
-    return headerValues;
 }
 
 void FileHeadReader::reset()
 {
     m_is_header_read  = false;
     // 重置到文件开始
-    file.getInputStream().seekg(0, std::ios::beg);
+    seek(0);
 }
 
-size_t FileHeadReader::tell() {    return static_cast<size_t>(file.getInputStream().tellg());}
+size_t FileHeadReader::tell() {    return FileReader::tell();}
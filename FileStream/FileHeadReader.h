@@ -3,6 +3,7 @@
 
 #include "FileReader.h"
 #include "FileFormat.h"
+#include <array>
 #include <string>
 #include <unordered_map>
 #include <stdexcept>
@@ -33,7 +34,17 @@ public:
 
     int getHeadSize();
 
-    std::unordered_map<std::string, u64>  getHeader();
+    // 文件头原始字节（小端序），共getHeadSize()字节
+    const u8 *getHeaderBytes() const { return m_header_bytes.data(); }
+
+    // 按文件头结构体解出文件头，结构体须与文件格式一致
+    template <typename Header>
+    Header getHeader() const {
+        if (m_format == nullptr || m_format->fields != Header::fields) {
+            throw std::runtime_error("Header type does not match file format");
+        }
+        return decode_header<Header>(m_header_bytes.data());
+    }
 
     // 获取文件大小
     size_t getFileSize();
@@ -46,12 +57,12 @@ public:
 
 private:
 
-    std::unordered_map<std::string, u64> readCompleteHeader();
-
-    std::unordered_map<std::string, u64> header;
+    // 一次读入整个定长文件头
+    void readCompleteHeader();
 
-    std::unordered_map<std::string, int> m_header_format;
+    const FileFormat *m_format;
 
+    std::array<u8, max_header_size()> m_header_bytes{};
 
     int m_head_size;
 
@@ -3,6 +3,7 @@
 
 #include "FileWriter.h"
 #include "FileFormat.h"
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -11,7 +12,7 @@ class FileHeadWriter : public FileWriter{
 private:
     std::string m_filename; // 存储文件名
 
-    std::unordered_map<std::string, int> m_file_format;
+    const FileFormat *m_file_format;
 
 public:
     typedef unsigned char u8;
@@ -22,11 +23,21 @@ public:
     // 写入头部数据
     bool writeHead(const std::vector<u8>& head);
 
-    // 写入特定格式的头部
-    bool writeFormattedHeader(const std::unordered_map<std::string,u64>& headerValues);
+    // 写入特定格式的头部：按结构体整块写出，大端系统上统一交换字节序
+    template <typename Header>
+    bool writeFormattedHeader(const Header &header) {
+        if (m_file_format == nullptr || m_file_format->fields != Header::fields) {
+            throw std::runtime_error("Header type does not match file format");
+        }
+        u8 bytes[sizeof(Header)];
+        encode_header(header, bytes);
+        FileWriter::writeBlock(bytes, sizeof(Header));
+        return true;
+    }
     
     //直接写入整个数据
     bool writeBlock(const std::vector<u8>& data);
+    using FileWriter::writeBlock;
 
     // 构造函数
     FileHeadWriter(const std::string& filename);
@@ -1,7 +1,9 @@
 #include "FileReader.h"
+#include "CopyCounter.h"
+#include <algorithm>
 #include <stdexcept>
 
-FileReader::FileReader(std::string filename) : file(filename, FileMode::READ) {
+FileReader::FileReader(std::string filename) : file(filename, FileMode::READ), buffer(new char[BUFFER_SIZE]) {
     // 构造函数，使用File类的READ模式打开文件
 }
 
@@ -9,88 +11,111 @@ FileReader::~FileReader() {
     // 析构函数，基类File的析构函数会处理文件关闭
 }
 
-// 读取单字节
-u8 FileReader::readu8() {
+size_t FileReader::fill() {
     if (!file.isOpen()) {
         throw std::runtime_error("File not open for reading");
     }
-    
-    u8 value;
-    file.getInputStream().read(reinterpret_cast<char*>(&value), sizeof(u8));
-    
-    if (file.getInputStream().fail()) {
+    buffer_pos = 0;
+    buffer_end = 0;
+    buffer_offset = static_cast<size_t>(file.getInputStream().tellg());
+    file.getInputStream().read(buffer.get(), BUFFER_SIZE);
+    buffer_end = static_cast<size_t>(file.getInputStream().gcount());
+    if (file.getInputStream().bad()) {
+        throw std::runtime_error("Failed to read data block");
+    }
+    // 读到末尾不算错误，清除状态以便之后seek和tell
+    if (file.getInputStream().eof()) {
+        file.getInputStream().clear();
+    }
+    return buffer_end;
+}
+
+void FileReader::readSlow(void *out, size_t size) {
+    if (readSome(out, size) != size) {
+        throw std::runtime_error("Unexpected end of file");
+    }
+}
+
+// 读取单字节
+u8 FileReader::readu8() {
+    if (buffer_pos == buffer_end && fill() == 0) {
         throw std::runtime_error("Failed to read u8 value");
     }
-    
-    return value;
+    return static_cast<u8>(buffer[buffer_pos++]);
 }
 
 // 读取双字节，处理字节序
 u16 FileReader::readu16() {
-    if (!file.isOpen()) {
-        throw std::runtime_error("File not open for reading");
-    }
-    
-    u16 value;
-    file.getInputStream().read(reinterpret_cast<char*>(&value), sizeof(u16));
-    
-    if (file.getInputStream().fail()) {
-        throw std::runtime_error("Failed to read u16 value");
-    }
-    
-    // 假设文件数据是小端序存储
-    // 如果系统是大端序，需要交换字节
-    if (file.isSystemBigEndian()) {
-        value = byteSwap(value);
-    }
-    
-    return value;
+    return readValue<u16>();
 }
 
 // 读取四字节，处理字节序
 u32 FileReader::readu32() {
-    if (!file.isOpen()) {
-        throw std::runtime_error("File not open for reading");
-    }
-    
-    u32 value;
-    file.getInputStream().read(reinterpret_cast<char*>(&value), sizeof(u32));
-    
-    if (file.getInputStream().fail()) {
-        throw std::runtime_error("Failed to read u32 value");
-    }
-    
-    // 假设文件数据是小端序存储
-    // 如果系统是大端序，需要交换字节
-    if (file.isSystemBigEndian()) {
-        value = byteSwap(value);
-    }
-    
-    return value;
+    return readValue<u32>();
 }
 
 // 读取八字节，处理字节序
 u64 FileReader::readu64() {
+    return readValue<u64>();
+}
+
+void FileReader::readBlock(void *out, size_t size) {
+    if (readSome(out, size) != size) {
+        throw std::runtime_error("Unexpected end of file");
+    }
+}
+
+size_t FileReader::readSome(void *out, size_t size) {
+    // 空读时out和缓冲都可能为空指针，memcpy不允许空指针
+    if (size == 0) {
+        return 0;
+    }
+    char *target = static_cast<char *>(out);
+    size_t count = std::min(size, buffer_end - buffer_pos);
+    std::memcpy(target, buffer.get() + buffer_pos, count);
+    CopyCounter::add(count);
+    buffer_pos += count;
+    if (count == size) {
+        return count;
+    }
+
     if (!file.isOpen()) {
         throw std::runtime_error("File not open for reading");
     }
-    
-    u64 value;
-    file.getInputStream().read(reinterpret_cast<char*>(&value), sizeof(u64));
-    
-    if (file.getInputStream().fail()) {
-        throw std::runtime_error("Failed to read u64 value");
+    if (size - count >= BUFFER_SIZE) {
+        // 剩余部分不小于缓冲区时直接读入目标，避免多一次复制；缓冲内容不再与文件流位置相邻，作废
+        buffer_pos = 0;
+        buffer_end = 0;
+        file.getInputStream().read(target + count, size - count);
+        count += static_cast<size_t>(file.getInputStream().gcount());
+        if (file.getInputStream().bad()) {
+            throw std::runtime_error("Failed to read data block");
+        }
+        if (file.getInputStream().eof()) {
+            file.getInputStream().clear();
+        }
+        return count;
     }
-    
-    // 假设文件数据是小端序存储
-    // 如果系统是大端序，需要交换字节
-    if (file.isSystemBigEndian()) {
-        value = byteSwap(value);
+    while (count < size && fill() > 0) {
+        size_t part = std::min(size - count, buffer_end);
+        std::memcpy(target + count, buffer.get(), part);
+        CopyCounter::add(part);
+        buffer_pos = part;
+        count += part;
     }
-    
-    return value;
+    return count;
+}
+
+void FileReader::seek(size_t position) {
+    if (buffer_end > 0 && position >= buffer_offset && position <= buffer_offset + buffer_end) {
+        buffer_pos = position - buffer_offset;
+        return;
+    }
+    buffer_pos = 0;
+    buffer_end = 0;
+    file.getInputStream().seekg(position, std::ios::beg);
 }
 
 size_t FileReader::tell(){
-    return static_cast<size_t>(file.getInputStream().tellg());
-}
\ No newline at end of file
+    return static_cast<size_t>(file.getInputStream().tellg()) - (buffer_end - buffer_pos);
+}
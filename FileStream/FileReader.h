@@ -4,7 +4,10 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cstring>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 #include "File.h"
 
 using namespace Swap;
@@ -14,7 +17,34 @@ class FileReader{
 protected:
     File file;
 
-     
+    // 内部读缓冲：小的定长读取从缓冲中取，不再每个字节调用一次ifstream::read
+    static constexpr size_t BUFFER_SIZE = 1 << 20;
+    std::unique_ptr<char[]> buffer; // 不初始化，小文件只触及实际读入的页
+    size_t buffer_pos = 0;
+    size_t buffer_end = 0;
+    size_t buffer_offset = 0; // 缓冲首字节在文件中的位置，缓冲非空时文件流位于buffer_offset + buffer_end
+
+    // 缓冲读空后从文件补充，返回补充的字节数（到达末尾时为0）
+    size_t fill();
+
+    // 缓冲中不足size字节时的慢路径
+    void readSlow(void *out, size_t size);
+
+    template <typename T>
+    T readValue() {
+        T value;
+        if (buffer_end - buffer_pos >= sizeof(T)) {
+            std::memcpy(&value, buffer.get() + buffer_pos, sizeof(T));
+            buffer_pos += sizeof(T);
+        } else {
+            readSlow(&value, sizeof(T));
+        }
+        // 文件数据按小端序存储，大端系统需要交换字节
+        if (file.isSystemBigEndian()) {
+            value = byteSwap(value);
+        }
+        return value;
+    }
 
 public:
     // 读取单字节
@@ -28,10 +58,32 @@ public:
 
     // 读取八字节，处理字节序
     u64 readu64();
+
+    // 读取恰好size字节，不足时抛出异常；大块直接读入目标内存，不经过内部缓冲
+    void readBlock(void *out, size_t size);
+
+    // 批量读取count个小端序整数，整块读入后统一处理字节序
+    template <typename T>
+    void readArray(T *values, size_t count) {
+        readBlock(values, count * sizeof(T));
+        if (file.isSystemBigEndian()) {
+            for (size_t i = 0; i < count; i++) {
+                values[i] = byteSwap(values[i]);
+            }
+        }
+    }
+
+    // 读取最多size字节，返回实际读取的字节数（到达末尾时小于size）
+    size_t readSome(void *buffer, size_t size);
+
+    // 移动读取位置，目标在缓冲内时只移动缓冲位置，否则丢弃缓冲中的数据
+    void seek(size_t position);
+
     FileReader(std::string filename);
 
     virtual ~FileReader();
 
+    // 逻辑读取位置（已扣除缓冲中尚未取走的字节）
     size_t tell();
 
     File &getFile()
@@ -40,4 +92,4 @@ public:
     };
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,80 +1,324 @@
 #include "FileWriter.h"
+#include "CopyCounter.h"
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
 #include <stdexcept>
 
-// 写入单字节
-void FileWriter::writeu8(u8 value) {
-    if (!file.isOpen()) {
-        throw std::runtime_error("File not open for writing");
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// 以Durability::BATCH写出、尚未确认落盘的文件
+std::mutex deferred_mutex;
+std::vector<std::string> deferred_files;
+}
+
+FileWriter::FileWriter(std::string filename, const WriteOptions &options, u64 final_size)
+    : file(filename, FileMode::WRITE), buffer(BUFFER_SIZE + DIRECT_ALIGN) {
+    alignBuffer();
+#ifndef _WIN32
+    // 文件已由文件流创建并截断，改为直接通过文件描述符写入
+    file.getOutputStream().close();
+    bool want_direct = options.direct_threshold != 0 && final_size >= options.direct_threshold;
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+#ifdef O_DIRECT
+    if (want_direct) {
+        fd = ::open(filename.c_str(), flags | O_DIRECT, 0644);
+        direct = fd >= 0;
     }
-    
-    file.getOutputStream().write(reinterpret_cast<const char*>(&value), sizeof(u8));
-    
-    if (file.getOutputStream().fail()) {
-        throw std::runtime_error("Failed to write u8 value");
+#endif
+    if (fd < 0) {
+        // 文件系统不支持O_DIRECT时按普通方式写出
+        fd = ::open(filename.c_str(), flags, 0644);
+    }
+    if (fd < 0) {
+        throw std::runtime_error("File open failed");
+    }
+#ifdef __linux__
+    if (options.preallocate && final_size > 0) {
+        // 只分配空间不改变文件长度，写入量与预计不同时也不会留下多余的数据；不支持时忽略
+        fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(final_size));
     }
+#endif
+    durability = options.durability;
+#else
+    (void)options;
+    (void)final_size;
+#endif
+}
+
+FileWriter::~FileWriter() {
+    // 析构函数中不能抛出异常，写入失败只能由close()报告
+    try {
+        flush();
+    } catch (...) {
+    }
+#ifndef _WIN32
+    if (fd >= 0) {
+        ::close(fd);
+    }
+#endif
+}
+
+void FileWriter::alignBuffer() {
+    uintptr_t address = reinterpret_cast<uintptr_t>(buffer.data());
+    buffer_data = buffer.data() + (DIRECT_ALIGN - address % DIRECT_ALIGN) % DIRECT_ALIGN;
+}
+
+// 写入单字节
+void FileWriter::writeu8(u8 value) {
+    writeValue(value);
 }
 
 // 写入双字节，处理字节序
 void FileWriter::writeu16(u16 value) {
-    if (!file.isOpen()) {
+    writeValue(value);
+}
+
+// 写入四字节，处理字节序
+void FileWriter::writeu32(u32 value) {
+    writeValue(value);
+}
+
+// 写入八字节，处理字节序
+void FileWriter::writeu64(u64 value) {
+    writeValue(value);
+}
+
+void FileWriter::writeBlock(const void *data, size_t size) {
+    // 空的vector的data()可能为空指针，memcpy不允许空指针
+    if (size == 0) {
+        return;
+    }
+    if (size <= BUFFER_SIZE - buffer_used) {
+        std::memcpy(buffer_data + buffer_used, data, size);
+        CopyCounter::add(size);
+        buffer_used += size;
+        return;
+    }
+    if (!isOpen()) {
         throw std::runtime_error("File not open for writing");
     }
-    
-    // 假设文件数据需要小端序存储
-    // 如果系统是大端序，需要交换字节
-    if (file.isSystemBigEndian()) {
-        value = byteSwap(value);
+    if (fd >= 0) {
+        if (!direct) {
+            writeDescriptor(buffer_data, buffer_used, data, size);
+            buffer_used = 0;
+            return;
+        }
+        // O_DIRECT不能直接写出调用者的内存，经对齐的缓冲分批写出
+        const char *bytes = static_cast<const char *>(data);
+        while (size > 0) {
+            size_t length = std::min(size, BUFFER_SIZE - buffer_used);
+            std::memcpy(buffer_data + buffer_used, bytes, length);
+            CopyCounter::add(length);
+            buffer_used += length;
+            bytes += length;
+            size -= length;
+            if (buffer_used == BUFFER_SIZE) {
+                spill();
+            }
+        }
+        return;
     }
-    
-    file.getOutputStream().write(reinterpret_cast<const char*>(&value), sizeof(u16));
-    
+    // 先交出缓冲中的少量数据，再整块写出。libstdc++的filebuf会把它暂存的数据
+    // 和随后的大块合并成一次writev，文件头、码表和位集因此只需一次系统调用
+    file.getOutputStream().write(buffer_data, buffer_used);
+    buffer_used = 0;
+    file.getOutputStream().write(static_cast<const char *>(data), size);
     if (file.getOutputStream().fail()) {
-        throw std::runtime_error("Failed to write u16 value");
+        throw std::runtime_error("Failed to write data block");
     }
 }
 
-// 写入四字节，处理字节序
-void FileWriter::writeu32(u32 value) {
-    if (!file.isOpen()) {
+void FileWriter::flush() {
+    if (buffer_used == 0) {
+        return;
+    }
+    if (!isOpen()) {
         throw std::runtime_error("File not open for writing");
     }
-    
-    // 假设文件数据需要小端序存储
-    // 如果系统是大端序，需要交换字节
-    if (file.isSystemBigEndian()) {
-        value = byteSwap(value);
+    if (fd >= 0) {
+        flushDescriptor(true);
+        return;
     }
-    
-    file.getOutputStream().write(reinterpret_cast<const char*>(&value), sizeof(u32));
-    
+    file.getOutputStream().write(buffer_data, buffer_used);
+    buffer_used = 0;
     if (file.getOutputStream().fail()) {
-        throw std::runtime_error("Failed to write u32 value");
+        throw std::runtime_error("Failed to write data block");
     }
 }
 
-// 写入八字节，处理字节序
-void FileWriter::writeu64(u64 value) {
-    if (!file.isOpen()) {
+void FileWriter::seek(u64 position) {
+    if (!isOpen()) {
         throw std::runtime_error("File not open for writing");
     }
-    
-    // 假设文件数据需要小端序存储
-    // 如果系统是大端序，需要交换字节
-    if (file.isSystemBigEndian()) {
-        value = byteSwap(value);
+
+    flush();
+#ifndef _WIN32
+    if (fd >= 0) {
+        if (lseek(fd, static_cast<off_t>(position), SEEK_SET) < 0) {
+            throw std::runtime_error("Failed to seek output file");
+        }
+        this->position = position;
+        return;
     }
-    
-    file.getOutputStream().write(reinterpret_cast<const char*>(&value), sizeof(u64));
-    
+#endif
+    file.getOutputStream().seekp(static_cast<std::streamoff>(position), std::ios::beg);
+
     if (file.getOutputStream().fail()) {
-        throw std::runtime_error("Failed to write u64 value");
+        throw std::runtime_error("Failed to seek output file");
     }
 }
 
+u64 FileWriter::tell() {
+    if (fd >= 0) {
+        return position + buffer_used;
+    }
+    return static_cast<u64>(file.getOutputStream().tellp()) + buffer_used;
+}
+
 bool FileWriter::close(){
-    if (file.isOpen()) {
-        // 由于File类的析构函数会自动关闭文件，我们只需要返回true
-        return true;
+    if (!isOpen()) {
+        return false;
+    }
+    flush();
+    if (fd < 0) {
+        // 文件仍由File类的析构函数关闭，这里只保证数据已交给系统
+        file.getOutputStream().flush();
+        return !file.getOutputStream().fail();
+    }
+    bool result = true;
+#ifndef _WIN32
+    if (durability == Durability::FILE) {
+        result = fdatasync(fd) == 0;
+    } else if (durability == Durability::BATCH) {
+#ifdef __linux__
+        // 先开始写回，统一同步时大多已经完成
+        sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+#endif
+        deferSync(file.getFileName());
+    }
+    result = ::close(fd) == 0 && result;
+#endif
+    fd = -1;
+    return result;
+}
+
+void FileWriter::spill() {
+    if (fd >= 0) {
+        flushDescriptor(false);
+    } else {
+        flush();
+    }
+}
+
+void FileWriter::flushDescriptor(bool all) {
+    size_t aligned = direct ? buffer_used / DIRECT_ALIGN * DIRECT_ALIGN : buffer_used;
+    writeDescriptor(buffer_data, aligned);
+    size_t rest = buffer_used - aligned;
+    if (rest > 0) {
+        std::memmove(buffer_data, buffer_data + aligned, rest);
+    }
+    buffer_used = rest;
+    if (all && rest > 0) {
+        // O_DIRECT要求长度按块对齐，末尾不足一块的部分关闭O_DIRECT后写出
+        leaveDirect();
+        writeDescriptor(buffer_data, rest);
+        buffer_used = 0;
+    }
+}
+
+void FileWriter::writeDescriptor(const void *data, size_t size) {
+    writeDescriptor(data, size, nullptr, 0);
+}
+
+void FileWriter::writeDescriptor(const void *data, size_t size, const void *tail, size_t tail_size) {
+#ifndef _WIN32
+    struct iovec parts[2] = {{const_cast<void *>(data), size}, {const_cast<void *>(tail), tail_size}};
+    int first = 0;
+    while (first < 2 && parts[first].iov_len == 0) {
+        first++;
     }
-    return false;
-}
\ No newline at end of file
+    while (first < 2) {
+        ssize_t written = ::writev(fd, parts + first, 2 - first);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EINVAL && direct) {
+                // 部分文件系统打开时接受O_DIRECT，写入时才拒绝
+                leaveDirect();
+                continue;
+            }
+            throw std::runtime_error("Failed to write data block");
+        }
+        position += static_cast<u64>(written);
+        size_t done = static_cast<size_t>(written);
+        while (first < 2 && done >= parts[first].iov_len) {
+            done -= parts[first].iov_len;
+            first++;
+        }
+        if (first < 2) {
+            parts[first].iov_base = static_cast<char *>(parts[first].iov_base) + done;
+            parts[first].iov_len -= done;
+        }
+        while (first < 2 && parts[first].iov_len == 0) {
+            first++;
+        }
+    }
+#else
+    (void)data;
+    (void)size;
+    (void)tail;
+    (void)tail_size;
+    throw std::runtime_error("File not open for writing");
+#endif
+}
+
+void FileWriter::leaveDirect() {
+#if !defined(_WIN32) && defined(O_DIRECT)
+    if (direct) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+        direct = false;
+    }
+#endif
+}
+
+void FileWriter::deferSync(const std::string &filename) {
+    std::lock_guard<std::mutex> lock(deferred_mutex);
+    deferred_files.push_back(filename);
+}
+
+std::vector<std::string> FileWriter::syncDeferred() {
+    std::vector<std::string> files;
+    {
+        std::lock_guard<std::mutex> lock(deferred_mutex);
+        files.swap(deferred_files);
+    }
+    std::vector<std::string> failed;
+    for (const std::string &filename : files) {
+        if (!syncFile(filename)) {
+            failed.push_back(filename);
+        }
+    }
+    return failed;
+}
+
+bool FileWriter::syncFile(const std::string &filename) {
+#ifndef _WIN32
+    int sync_fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (sync_fd < 0) {
+        return false;
+    }
+    bool result = fdatasync(sync_fd) == 0;
+    return ::close(sync_fd) == 0 && result;
+#else
+    (void)filename;
+    return true;
+#endif
+}
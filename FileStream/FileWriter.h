@@ -1,7 +1,11 @@
 #ifndef FILEWRITER_H
 #define FILEWRITER_H
 
+#include <cstring>
+#include <string>
+#include <vector>
 #include "File.h"
+#include "WriteOptions.h"
 
 using namespace Swap;
 
@@ -13,21 +17,103 @@ class FileWriter{
     typedef unsigned long long u64;
 
 public:
-    FileWriter(std::string filename) : file(filename, FileMode::WRITE) {};
+    FileWriter(std::string filename) : file(filename, FileMode::WRITE), buffer(BUFFER_SIZE + DIRECT_ALIGN) { alignBuffer(); };
+
+    // 按options写出，final_size为已知的最终大小（0为未知），用于预分配和决定是否使用O_DIRECT。
+    // POSIX平台上直接通过文件描述符写入，其他平台忽略options，按普通文件流写出
+    FileWriter(std::string filename, const WriteOptions &options, u64 final_size = 0);
+
+    // 析构时写出缓冲中剩余的数据；需要知道是否写入成功时应调用close()
+    virtual ~FileWriter();
 
     void writeu8(u8 value);
     void writeu16(u16 value);
     void writeu32(u32 value);
     void writeu64(u64 value);
 
+    // 写入size字节；小块进入内部缓冲，大块与缓冲中的数据一起直接交给文件流
+    void writeBlock(const void *data, size_t size);
+
+    // 批量写入count个整数，按小端序存储
+    template <typename T>
+    void writeArray(const T *values, size_t count) {
+        if (!file.isSystemBigEndian()) {
+            writeBlock(values, count * sizeof(T));
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            writeValue(values[i]);
+        }
+    }
+
+    // 把缓冲中的数据交给文件流
+    void flush();
+
+    // 写入位置（用于流式写入后回填文件头）
+    void seek(u64 position);
+    u64 tell();
+
+    // 写出缓冲并检查文件流状态，返回是否全部写入成功；按持久化策略同步或登记待同步
     bool close();
 
+    // 等待以Durability::BATCH写出的文件全部落盘，返回同步失败的文件
+    static std::vector<std::string> syncDeferred();
+
+    // 登记一个已写完、等待批量落盘的文件（内存映射输出、异步I/O等其他写出方式使用）
+    static void deferSync(const std::string &filename);
+
+    // 打开已写完的文件并fdatasync，返回是否成功
+    static bool syncFile(const std::string &filename);
+
     File& getFile() {
             return file;
         };
 protected : File file;
 
+    // 内部写缓冲：定长小值先攒在缓冲中，不再每个值调用一次ofstream::write
+    static constexpr size_t BUFFER_SIZE = 1 << 20;
+    // O_DIRECT要求缓冲地址、写入长度和文件偏移按块对齐
+    static constexpr size_t DIRECT_ALIGN = 4096;
+    std::vector<char> buffer;
+    char *buffer_data = nullptr; // 缓冲起点，按DIRECT_ALIGN对齐
+    size_t buffer_used = 0;
+
+    // 文件描述符写出方式（POSIX平台按WriteOptions写出时），fd >= 0时不使用file中的文件流
+    int fd = -1;
+    bool direct = false;         // 仍以O_DIRECT写出
+    Durability durability = Durability::NONE;
+    u64 position = 0;            // 文件描述符的当前写入位置
+
+    template <typename T>
+    void writeValue(T value) {
+        // 文件数据按小端序存储，大端系统需要交换字节
+        if (file.isSystemBigEndian()) {
+            value = byteSwap(value);
+        }
+        if (BUFFER_SIZE - buffer_used < sizeof(T)) {
+            spill();
+        }
+        std::memcpy(buffer_data + buffer_used, &value, sizeof(T));
+        buffer_used += sizeof(T);
+    }
+
+private:
+    void alignBuffer();
+
+    bool isOpen() const { return fd >= 0 || file.isOpen(); }
+
+    // 缓冲将满时写出；O_DIRECT时只写出对齐的整块，其余留在缓冲中
+    void spill();
+
+    // 文件描述符方式写出缓冲，all为true时连同不足一块的末尾一起写出
+    void flushDescriptor(bool all);
+
+    void writeDescriptor(const void *data, size_t size);
+
+    // 缓冲和一个大块一起写出（writev）
+    void writeDescriptor(const void *data, size_t size, const void *tail, size_t tail_size);
 
+    void leaveDirect();
 };
 
 #endif
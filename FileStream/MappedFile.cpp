@@ -0,0 +1,213 @@
+#include "MappedFile.h"
+#include "FileWriter.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &filename, bool populate) {
+    (void)populate;
+    file_handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        file_handle = nullptr;
+        throw std::runtime_error("File open failed");
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size)) {
+        CloseHandle(file_handle);
+        throw std::runtime_error("Failed to get file size");
+    }
+    length = static_cast<size_t>(file_size.QuadPart);
+    if (length == 0) {
+        return;
+    }
+    mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle == nullptr) {
+        CloseHandle(file_handle);
+        throw std::runtime_error("Failed to map file");
+    }
+    mapped = static_cast<const u8 *>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    if (mapped == nullptr) {
+        CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+        throw std::runtime_error("Failed to map file");
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (mapped != nullptr) {
+        UnmapViewOfFile(mapped);
+    }
+    if (mapping_handle != nullptr) {
+        CloseHandle(mapping_handle);
+    }
+    if (file_handle != nullptr) {
+        CloseHandle(file_handle);
+    }
+}
+
+MappedOutputFile::MappedOutputFile(const std::string &filename, size_t size, const WriteOptions &options)
+    : length(size), path(filename) {
+    (void)options;
+    file_handle = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        file_handle = nullptr;
+        throw std::runtime_error("File open failed");
+    }
+    if (length == 0) {
+        return;
+    }
+    LARGE_INTEGER file_size;
+    file_size.QuadPart = static_cast<LONGLONG>(length);
+    // 映射对象按给定大小创建时会同时扩展文件
+    mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READWRITE, file_size.HighPart, file_size.LowPart, nullptr);
+    if (mapping_handle == nullptr) {
+        CloseHandle(file_handle);
+        file_handle = nullptr;
+        throw std::runtime_error("Failed to map output file");
+    }
+    mapped = static_cast<u8 *>(MapViewOfFile(mapping_handle, FILE_MAP_WRITE, 0, 0, 0));
+    if (mapped == nullptr) {
+        CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+        mapping_handle = nullptr;
+        file_handle = nullptr;
+        throw std::runtime_error("Failed to map output file");
+    }
+}
+
+MappedOutputFile::~MappedOutputFile() {
+    close();
+}
+
+bool MappedOutputFile::close() {
+    bool result = true;
+    if (mapped != nullptr) {
+        result = UnmapViewOfFile(mapped) != 0;
+        mapped = nullptr;
+    }
+    if (mapping_handle != nullptr) {
+        CloseHandle(mapping_handle);
+        mapping_handle = nullptr;
+    }
+    if (file_handle != nullptr) {
+        result = CloseHandle(file_handle) != 0 && result;
+        file_handle = nullptr;
+    }
+    return result;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &filename, bool populate) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("File open failed");
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("Failed to get file size");
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (length == 0) {
+        close(fd);
+        return;
+    }
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if (populate) {
+        flags |= MAP_POPULATE;
+    }
+#else
+    (void)populate;
+#endif
+    void *address = mmap(nullptr, length, PROT_READ, flags, fd, 0);
+    // 映射建立后文件描述符不再需要
+    close(fd);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("Failed to map file");
+    }
+    mapped = static_cast<const u8 *>(address);
+    madvise(address, length, MADV_SEQUENTIAL);
+    madvise(address, length, MADV_WILLNEED);
+}
+
+MappedFile::~MappedFile() {
+    if (mapped != nullptr) {
+        munmap(const_cast<u8 *>(mapped), length);
+    }
+}
+
+MappedOutputFile::MappedOutputFile(const std::string &filename, size_t size, const WriteOptions &options)
+    : length(size), path(filename), durability(options.durability) {
+    fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("File open failed");
+    }
+    if (ftruncate(fd, static_cast<off_t>(length)) != 0) {
+        ::close(fd);
+        fd = -1;
+        throw std::runtime_error("Failed to resize output file");
+    }
+    if (length == 0) {
+        return;
+    }
+#ifdef __linux__
+    if (options.preallocate) {
+        // ftruncate只设长度，文件仍是稀疏的；这里一次分配全部块，不支持时忽略
+        fallocate(fd, 0, 0, static_cast<off_t>(length));
+    }
+#endif
+    void *address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        ::close(fd);
+        fd = -1;
+        throw std::runtime_error("Failed to map output file");
+    }
+    mapped = static_cast<u8 *>(address);
+    madvise(address, length, MADV_SEQUENTIAL);
+}
+
+MappedOutputFile::~MappedOutputFile() {
+    close();
+}
+
+bool MappedOutputFile::close() {
+    bool result = true;
+    if (mapped != nullptr) {
+        if (durability == Durability::FILE) {
+            result = msync(mapped, length, MS_SYNC) == 0;
+        }
+        // 未要求持久化时脏页由内核写回，这里不等待落盘
+        result = munmap(mapped, length) == 0 && result;
+        mapped = nullptr;
+    }
+    if (fd >= 0) {
+        if (durability == Durability::FILE) {
+            // 文件长度等元数据也要落盘
+            result = fdatasync(fd) == 0 && result;
+        } else if (durability == Durability::BATCH) {
+#ifdef __linux__
+            // 解除映射后脏页仍在页缓存中，先开始写回，由FileWriter::syncDeferred()统一等待
+            sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+#endif
+            FileWriter::deferSync(path);
+        }
+        result = ::close(fd) == 0 && result;
+        fd = -1;
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include "WriteOptions.h"
+
+// 只读内存映射文件：整个文件映射为一段连续的只读内存，直接在映射上统计、编码和解码，
+// 不再先复制到std::vector。映射建立后提示内核顺序访问并提前预读；
+// populate为true时建立映射时就读入全部页面（Linux的MAP_POPULATE），之后访问不再缺页
+class MappedFile
+{
+    typedef unsigned char u8;
+
+public:
+    explicit MappedFile(const std::string &filename, bool populate = false);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // 空文件时为nullptr
+    const u8 *data() const { return mapped; }
+
+    size_t size() const { return length; }
+
+private:
+    const u8 *mapped = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void *file_handle = nullptr;
+    void *mapping_handle = nullptr;
+#endif
+};
+
+// 可写的内存映射输出文件：创建（或截断）文件并把长度设为size，映射后由调用者直接写入，
+// 没有逐块write的循环。新扩展的部分读出为0。
+// options.preallocate时按size分配磁盘空间，不留下稀疏文件；关闭时按options.durability同步，O_DIRECT不适用于映射
+class MappedOutputFile
+{
+    typedef unsigned char u8;
+
+public:
+    MappedOutputFile(const std::string &filename, size_t size, const WriteOptions &options = WriteOptions());
+
+    ~MappedOutputFile();
+
+    MappedOutputFile(const MappedOutputFile &) = delete;
+    MappedOutputFile &operator=(const MappedOutputFile &) = delete;
+
+    // size为0时为nullptr
+    u8 *data() { return mapped; }
+
+    size_t size() const { return length; }
+
+    // 解除映射并关闭文件，返回是否成功；之后不能再访问data()
+    bool close();
+
+private:
+    u8 *mapped = nullptr;
+    size_t length = 0;
+    std::string path;
+    Durability durability = Durability::NONE;
+#ifdef _WIN32
+    void *file_handle = nullptr;
+    void *mapping_handle = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+#endif // MAPPEDFILE_H
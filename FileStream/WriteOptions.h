@@ -0,0 +1,20 @@
+#ifndef WRITEOPTIONS_H
+#define WRITEOPTIONS_H
+
+// 写出后的持久化策略
+enum class Durability {
+    NONE,  // 交给系统后即返回，由内核择机写回
+    FILE,  // 每个文件关闭前fdatasync，返回时数据已落盘
+    BATCH, // 关闭时只开始写回并登记，一批文件写完后由FileWriter::syncDeferred()统一等待落盘
+};
+
+// 输出文件的写出方式（仅POSIX平台生效，其他平台按普通文件流写出）
+struct WriteOptions {
+    typedef unsigned long long u64;
+
+    bool preallocate = true;       // 已知最终大小时先按该大小分配磁盘空间（fallocate），避免边写边扩展造成碎片
+    u64 direct_threshold = 0;      // 已知最终大小不小于该值时用O_DIRECT经对齐缓冲写出，不占用页缓存；0为不使用
+    Durability durability = Durability::NONE;
+};
+
+#endif // WRITEOPTIONS_H
@@ -0,0 +1,496 @@
+#include "ioEngine.h"
+#include "../FileStream/FileWriter.h"
+#include "../logger/Logger.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define IO_ENGINE_URING 1
+#endif
+#endif
+
+#ifdef IO_ENGINE_URING
+#include <linux/io_uring.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// 每个文件按块拆分读写，块数多于提交队列时排队等待
+const size_t CHUNK_SIZE = 1 << 20;
+// io_uring提交队列长度，同时在途的块数不超过它，完成队列是它的两倍，不会溢出
+const unsigned RING_ENTRIES = 64;
+// 退回到同步读写时的I/O线程数上限
+const size_t MAX_IO_THREADS = 8;
+}
+
+struct IoEngine::Chunk
+{
+    Request *request;
+    unsigned long long offset;
+    size_t length;
+    bool sync; // 数据写完后的fdatasync
+#ifdef IO_ENGINE_URING
+    iovec iov;
+#endif
+};
+
+struct IoEngine::Request
+{
+    bool is_write = false;
+    std::string path;
+    std::vector<u8> data;
+    ReadCallback on_read;
+    WriteCallback on_write;
+    std::string error;
+    int fd = -1;
+    std::vector<Chunk> chunks;
+    size_t remaining = 0; // 未完成的块数
+    Chunk sync_chunk;
+};
+
+#ifdef IO_ENGINE_URING
+
+// 直接用系统调用建立的io_uring，不依赖liburing
+struct IoEngine::Ring
+{
+    int fd = -1;
+    unsigned entries = 0;
+    void *sq_ptr = MAP_FAILED;
+    size_t sq_len = 0;
+    void *cq_ptr = MAP_FAILED;
+    size_t cq_len = 0;
+    io_uring_sqe *sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+    size_t sqes_len = 0;
+    unsigned *sq_head = nullptr;
+    unsigned *sq_tail = nullptr;
+    unsigned *sq_mask = nullptr;
+    unsigned *sq_array = nullptr;
+    unsigned *cq_head = nullptr;
+    unsigned *cq_tail = nullptr;
+    unsigned *cq_mask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+
+    // 内核不支持或被禁止时返回nullptr
+    static Ring *create(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) {
+            return nullptr;
+        }
+        std::unique_ptr<Ring> ring(new Ring());
+        ring->fd = fd;
+        ring->entries = params.sq_entries;
+        ring->sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        ring->cq_len = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            ring->sq_len = ring->cq_len = std::max(ring->sq_len, ring->cq_len);
+        }
+        ring->sq_ptr = mmap(nullptr, ring->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (ring->sq_ptr == MAP_FAILED) {
+            return nullptr;
+        }
+        if (!single_mmap) {
+            ring->cq_ptr = mmap(nullptr, ring->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (ring->cq_ptr == MAP_FAILED) {
+                return nullptr;
+            }
+        }
+        ring->sqes_len = params.sq_entries * sizeof(io_uring_sqe);
+        ring->sqes = static_cast<io_uring_sqe *>(
+            mmap(nullptr, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (ring->sqes == MAP_FAILED) {
+            return nullptr;
+        }
+        char *sq = static_cast<char *>(ring->sq_ptr);
+        char *cq = static_cast<char *>(single_mmap ? ring->sq_ptr : ring->cq_ptr);
+        ring->sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        ring->sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        ring->sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        ring->sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        ring->cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        ring->cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        ring->cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        ring->cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        return ring.release();
+    }
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqes_len);
+        }
+        if (cq_ptr != MAP_FAILED) {
+            munmap(cq_ptr, cq_len);
+        }
+        if (sq_ptr != MAP_FAILED) {
+            munmap(sq_ptr, sq_len);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    // 把一个块放入提交队列，调用者保证队列未满
+    void push(Chunk *chunk) {
+        Request *request = chunk->request;
+        unsigned tail = *sq_tail;
+        unsigned index = tail & *sq_mask;
+        io_uring_sqe *sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->fd = request->fd;
+        sqe->user_data = reinterpret_cast<unsigned long long>(chunk);
+        if (chunk->sync) {
+            sqe->opcode = IORING_OP_FSYNC;
+            sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+            sq_array[index] = index;
+            __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+            return;
+        }
+        chunk->iov.iov_base = request->data.data() + chunk->offset;
+        chunk->iov.iov_len = chunk->length;
+        sqe->opcode = request->is_write ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe->off = chunk->offset;
+        sqe->addr = reinterpret_cast<unsigned long long>(&chunk->iov);
+        sqe->len = 1;
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    // 提交to_submit个请求并至少等待wait_for个完成，返回内核取走的请求数
+    unsigned enter(unsigned to_submit, unsigned wait_for) {
+        while (true) {
+            long submitted = syscall(__NR_io_uring_enter, fd, to_submit, wait_for,
+                                     wait_for > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if (submitted >= 0) {
+                return static_cast<unsigned>(submitted);
+            }
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                throw std::runtime_error("io_uring_enter failed");
+            }
+            if (errno != EINTR) {
+                return 0; // 内核暂时无法接收，先处理已有的完成事件
+            }
+        }
+    }
+};
+
+#else
+
+struct IoEngine::Ring
+{
+};
+
+#endif
+
+IoEngine::IoEngine(size_t queue_depth, bool use_uring, const WriteOptions &output)
+    : queue_depth_(std::max<size_t>(queue_depth, 1)), output_(output), outstanding_(0), stop_(false)
+{
+#ifdef IO_ENGINE_URING
+    if (use_uring) {
+        ring_.reset(Ring::create(RING_ENTRIES));
+    }
+#else
+    (void)use_uring;
+#endif
+    if (ring_) {
+        Logger::getInstance().debug("异步I/O使用io_uring");
+        workers_.emplace_back([this] { ringLoop(); });
+    } else {
+        size_t threads = std::min(queue_depth_, MAX_IO_THREADS);
+        Logger::getInstance().debug("异步I/O使用 " + std::to_string(threads) + " 个I/O线程");
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { threadLoop(); });
+        }
+    }
+}
+
+IoEngine::~IoEngine()
+{
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void IoEngine::read(const std::string &path, ReadCallback done)
+{
+    Request *request = new Request();
+    request->path = path;
+    request->on_read = std::move(done);
+    submit(request);
+}
+
+void IoEngine::write(const std::string &path, std::vector<u8> data, WriteCallback done)
+{
+    Request *request = new Request();
+    request->is_write = true;
+    request->path = path;
+    request->data = std::move(data);
+    request->on_write = std::move(done);
+    submit(request);
+}
+
+void IoEngine::wait()
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    idle_cv_.wait(lock, [this] { return outstanding_ == 0; });
+}
+
+void IoEngine::submit(Request *request)
+{
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (stop_) {
+            delete request;
+            throw std::runtime_error("Cannot submit request to stopped IoEngine");
+        }
+        pending_.push_back(request);
+        outstanding_++;
+    }
+    cv_.notify_one();
+}
+
+void IoEngine::finishRequest(Request *request)
+{
+    try {
+        if (request->is_write) {
+            if (request->on_write) {
+                request->on_write(request->error.empty());
+            }
+        } else if (request->on_read) {
+            if (!request->error.empty()) {
+                request->data.clear();
+            }
+            request->on_read(std::move(request->data), request->error);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "IoEngine callback exception: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "IoEngine callback unknown exception" << std::endl;
+    }
+    delete request;
+
+    // 回调中提交的新请求已计入，outstanding_不会提前归零
+    std::unique_lock<std::mutex> lock(mtx_);
+    if (--outstanding_ == 0) {
+        idle_cv_.notify_all();
+    }
+}
+
+void IoEngine::threadLoop()
+{
+    while (true) {
+        Request *request;
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                return;
+            }
+            request = pending_.front();
+            pending_.pop_front();
+        }
+
+        if (request->is_write) {
+            std::ofstream out(request->path, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char *>(request->data.data()), static_cast<std::streamsize>(request->data.size()));
+            out.close();
+            if (!out) {
+                request->error = "File write failed";
+            } else if (output_.durability == Durability::FILE && !FileWriter::syncFile(request->path)) {
+                request->error = "File sync failed";
+            } else if (output_.durability == Durability::BATCH) {
+                FileWriter::deferSync(request->path);
+            }
+        } else {
+            std::ifstream in(request->path, std::ios::binary | std::ios::ate);
+            if (!in) {
+                request->error = "File open failed";
+            } else {
+                std::streamoff size = in.tellg();
+                in.seekg(0);
+                request->data.resize(static_cast<size_t>(size));
+                in.read(reinterpret_cast<char *>(request->data.data()), size);
+                if (!in) {
+                    request->error = "File read failed";
+                }
+            }
+        }
+        finishRequest(request);
+    }
+}
+
+#ifdef IO_ENGINE_URING
+
+bool IoEngine::startRequest(Request *request, std::deque<Chunk *> &ready)
+{
+    if (request->is_write) {
+        request->fd = open(request->path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    } else {
+        request->fd = open(request->path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    if (request->fd < 0) {
+        request->error = "File open failed";
+        return false;
+    }
+    if (!request->is_write) {
+        struct stat info;
+        if (fstat(request->fd, &info) != 0) {
+            request->error = "Failed to get file size";
+            return false;
+        }
+        request->data.resize(static_cast<size_t>(info.st_size));
+    } else if (output_.preallocate && !request->data.empty()) {
+        // 只分配空间不改变文件长度，不支持时忽略
+        fallocate(request->fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(request->data.size()));
+    }
+    size_t size = request->data.size();
+    request->chunks.reserve((size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    for (size_t offset = 0; offset < size; offset += CHUNK_SIZE) {
+        request->chunks.push_back(Chunk{request, offset, std::min(CHUNK_SIZE, size - offset), false, iovec()});
+    }
+    // chunks不再增长，块的地址可以作为user_data
+    for (Chunk &chunk : request->chunks) {
+        ready.push_back(&chunk);
+    }
+    request->remaining = request->chunks.size();
+    return request->remaining > 0;
+}
+
+void IoEngine::ringLoop()
+{
+    std::deque<Chunk *> ready; // 等待放入提交队列的块
+    size_t active = 0;         // 已打开文件、尚未完成的请求数
+    unsigned in_ring = 0;      // 已放入提交队列、尚未完成的块数
+    unsigned unsubmitted = 0;  // 已放入提交队列、内核尚未取走的块数
+
+    auto complete = [&](Request *request) {
+        if (request->is_write && request->fd >= 0 && request->error.empty() && output_.durability == Durability::BATCH) {
+            // 先开始写回，由FileWriter::syncDeferred()统一等待
+            sync_file_range(request->fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+            FileWriter::deferSync(request->path);
+        }
+        if (request->fd >= 0 && close(request->fd) != 0 && request->error.empty()) {
+            request->error = "File close failed";
+        }
+        request->fd = -1;
+        active--;
+        finishRequest(request);
+    };
+
+    while (true) {
+        std::vector<Request *> started;
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            if (active == 0) {
+                cv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+                if (pending_.empty()) {
+                    return;
+                }
+            }
+            // 在途的块未完成时不等待新请求，新请求在下一批完成后取出
+            while (active + started.size() < queue_depth_ && !pending_.empty()) {
+                started.push_back(pending_.front());
+                pending_.pop_front();
+            }
+        }
+        for (Request *request : started) {
+            active++;
+            if (!startRequest(request, ready)) {
+                complete(request);
+            }
+        }
+
+        while (!ready.empty() && in_ring < ring_->entries) {
+            ring_->push(ready.front());
+            ready.pop_front();
+            in_ring++;
+            unsubmitted++;
+        }
+        if (in_ring == 0) {
+            continue;
+        }
+        unsubmitted -= ring_->enter(unsubmitted, 1);
+
+        // 先取出全部完成事件再处理，处理时可能放入新的块
+        std::vector<std::pair<Chunk *, int>> events;
+        unsigned head = *ring_->cq_head;
+        unsigned tail = __atomic_load_n(ring_->cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe &cqe = ring_->cqes[head & *ring_->cq_mask];
+            events.emplace_back(reinterpret_cast<Chunk *>(cqe.user_data), cqe.res);
+        }
+        __atomic_store_n(ring_->cq_head, head, __ATOMIC_RELEASE);
+
+        for (const auto &event : events) {
+            Chunk *chunk = event.first;
+            Request *request = chunk->request;
+            int result = event.second;
+            in_ring--;
+            if (result == -EINTR || result == -EAGAIN) {
+                ready.push_front(chunk);
+                continue;
+            }
+            if (chunk->sync) {
+                if (result < 0 && request->error.empty()) {
+                    request->error = "File sync failed";
+                }
+            } else if (result < 0) {
+                if (request->error.empty()) {
+                    request->error = std::string("I/O failed: ") + std::strerror(-result);
+                }
+            } else if (result == 0) {
+                if (request->error.empty()) {
+                    request->error = "Unexpected end of file";
+                }
+            } else if (static_cast<size_t>(result) < chunk->length) {
+                // 部分完成，剩余部分重新提交
+                chunk->offset += result;
+                chunk->length -= result;
+                ready.push_front(chunk);
+                continue;
+            }
+            if (--request->remaining > 0) {
+                continue;
+            }
+            if (request->is_write && !chunk->sync && request->error.empty() && output_.durability == Durability::FILE) {
+                // 数据全部写完后再排一个fdatasync，落盘后才算完成
+                request->sync_chunk = Chunk{request, 0, 0, true, iovec()};
+                request->remaining = 1;
+                ready.push_back(&request->sync_chunk);
+                continue;
+            }
+            complete(request);
+        }
+    }
+}
+
+#else
+
+bool IoEngine::startRequest(Request *, std::deque<Chunk *> &)
+{
+    return false;
+}
+
+void IoEngine::ringLoop()
+{
+}
+
+#endif
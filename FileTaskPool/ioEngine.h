@@ -0,0 +1,76 @@
+#ifndef IO_ENGINE_H
+#define IO_ENGINE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../FileStream/WriteOptions.h"
+
+// 批量转换用的异步文件读写引擎
+// 调用者提交整个文件的读、写请求后立即返回，引擎同时保持最多queue_depth个文件在途，完成后在引擎线程上回调。
+// Linux上使用io_uring：每个文件按块拆成多个读写请求批量提交，设备队列保持满载，计算线程不阻塞在I/O上；
+// io_uring不可用（旧内核、被seccomp禁止、非Linux平台）时退回到若干I/O线程同步读写。
+// 写出按output预分配和持久化；数据来自调用者的任意内存，不使用O_DIRECT
+class IoEngine
+{
+public:
+    typedef unsigned char u8;
+
+    // 读取完成：error为空表示成功，data为文件的全部内容
+    using ReadCallback = std::function<void(std::vector<u8> &&data, const std::string &error)>;
+    // 写入完成：ok表示全部写入并成功关闭
+    using WriteCallback = std::function<void(bool ok)>;
+
+    // use_uring为false时总是使用I/O线程
+    explicit IoEngine(size_t queue_depth = 32, bool use_uring = true, const WriteOptions &output = WriteOptions());
+
+    // 等待所有请求完成后退出
+    ~IoEngine();
+
+    IoEngine(const IoEngine&) = delete;
+    IoEngine& operator=(const IoEngine&) = delete;
+
+    // 回调在引擎线程上执行，应尽快返回（耗时的处理交给线程池），回调中可以继续提交请求
+    void read(const std::string &path, ReadCallback done);
+
+    void write(const std::string &path, std::vector<u8> data, WriteCallback done);
+
+    // 等待已提交的请求（包括回调中新提交的）全部完成
+    void wait();
+
+    bool usingUring() const { return ring_ != nullptr; }
+
+private:
+    struct Request;
+    struct Chunk;
+    struct Ring;
+
+    void submit(Request *request);
+
+    void threadLoop();
+
+    void ringLoop();
+
+    // 打开文件并把请求拆成块，失败时返回false并记录错误
+    bool startRequest(Request *request, std::deque<Chunk *> &ready);
+
+    void finishRequest(Request *request);
+
+    size_t queue_depth_;
+    WriteOptions output_;
+    std::unique_ptr<Ring> ring_;
+    std::vector<std::thread> workers_;
+    std::deque<Request *> pending_; // 尚未开始的请求
+    size_t outstanding_;            // 已提交未完成的请求数（包括pending_中的）
+    bool stop_;
+    std::mutex mtx_;
+    std::condition_variable cv_;      // 有新请求或停止
+    std::condition_variable idle_cv_; // outstanding_变为0
+};
+
+#endif // IO_ENGINE_H
@@ -0,0 +1,122 @@
+#include "prefetcher.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// 对整个文件发出页缓存提示，打不开的文件忽略
+void advise(const std::string &path, bool will_need) {
+#if !defined(_WIN32) && defined(POSIX_FADV_WILLNEED)
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    posix_fadvise(fd, 0, 0, will_need ? POSIX_FADV_WILLNEED : POSIX_FADV_DONTNEED);
+    close(fd);
+#else
+    (void)path;
+    (void)will_need;
+#endif
+}
+}
+
+Prefetcher::Prefetcher() : stop_(false)
+{
+    worker_ = std::thread([this] { run(); });
+}
+
+Prefetcher::~Prefetcher()
+{
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void Prefetcher::configure(const PrefetchOptions &options) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    options_ = options;
+}
+
+PrefetchOptions Prefetcher::options() const {
+    std::unique_lock<std::mutex> lock(mtx_);
+    return options_;
+}
+
+void Prefetcher::enqueue(const std::string &path) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    queued_.emplace_back(path, false);
+}
+
+void Prefetcher::begin(const std::string &path) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    for (auto it = queued_.begin(); it != queued_.end(); ++it) {
+        if (it->first == path) {
+            queued_.erase(it);
+            break;
+        }
+    }
+    // 队列前面的输入由其他工作线程正在取用或即将取用，预读从队首开始的depth个
+    size_t count = 0;
+    bool added = false;
+    for (auto &entry : queued_) {
+        if (count++ >= options_.depth) {
+            break;
+        }
+        if (!entry.second) {
+            entry.second = true;
+            hints_.emplace_back(entry.first, true);
+            added = true;
+        }
+    }
+    if (added) {
+        cv_.notify_one();
+    }
+}
+
+void Prefetcher::done(const std::string &path) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    if (options_.drop_processed) {
+        hints_.emplace_back(path, false);
+        cv_.notify_one();
+    }
+}
+
+void Prefetcher::willNeed(const std::string &path) {
+    hint(path, true);
+}
+
+void Prefetcher::dontNeed(const std::string &path) {
+    hint(path, false);
+}
+
+void Prefetcher::hint(const std::string &path, bool will_need) {
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        hints_.emplace_back(path, will_need);
+    }
+    cv_.notify_one();
+}
+
+void Prefetcher::run() {
+    while (true) {
+        std::pair<std::string, bool> next;
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_.wait(lock, [this] { return stop_ || !hints_.empty(); });
+            // 停止时剩余的提示不再发出
+            if (stop_) {
+                return;
+            }
+            next = std::move(hints_.front());
+            hints_.pop_front();
+        }
+        advise(next.first, next.second);
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+// 读取侧的页缓存提示
+struct PrefetchOptions {
+    size_t depth = 4;           // 一个任务开始时，提前预读排在它之后的几个输入；0为不预读
+    bool drop_processed = true; // 处理完的输入从页缓存中丢弃（FADV_DONTNEED），不挤占同机其他程序的缓存
+};
+
+// 按任务队列顺序预读输入文件
+// 提交任务时登记输入，任务开始时对队列中之后的depth个输入发出posix_fadvise(WILLNEED)，
+// 工作线程取到它们时数据已在页缓存中；任务结束后按配置对输入发出FADV_DONTNEED。
+// 提示由一个后台线程发出，工作线程不会阻塞在预读上。非POSIX平台上不做任何事
+class Prefetcher
+{
+public:
+    Prefetcher();
+
+    ~Prefetcher();
+
+    Prefetcher(const Prefetcher&) = delete;
+    Prefetcher& operator=(const Prefetcher&) = delete;
+
+    void configure(const PrefetchOptions &options);
+
+    PrefetchOptions options() const;
+
+    // 输入进入任务队列
+    void enqueue(const std::string &path);
+
+    // 开始处理path：移出队列，并预读队列中接下来depth个尚未预读的输入
+    void begin(const std::string &path);
+
+    // 处理完毕，按配置丢弃path的页缓存
+    void done(const std::string &path);
+
+    // 直接发出提示，供自行管理读取顺序的批量转换使用
+    void willNeed(const std::string &path);
+
+    void dontNeed(const std::string &path);
+
+    // 任务执行期间的作用域：构造时begin，析构时done（任务抛出异常时也会执行）
+    class Scope
+    {
+    public:
+        Scope(Prefetcher &prefetcher, const std::string &path) : prefetcher_(prefetcher), path_(path) {
+            prefetcher_.begin(path_);
+        }
+
+        ~Scope() { prefetcher_.done(path_); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Prefetcher &prefetcher_;
+        std::string path_;
+    };
+
+private:
+    void hint(const std::string &path, bool will_need);
+
+    void run();
+
+    PrefetchOptions options_;
+    std::deque<std::pair<std::string, bool>> queued_; // 排队中的输入，second为是否已预读
+    std::deque<std::pair<std::string, bool>> hints_;  // 待发出的提示，second为true表示WILLNEED
+    bool stop_;
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    std::thread worker_;
+};
+
+#endif // PREFETCHER_H
@@ -0,0 +1,69 @@
+#include "adaptivehuffman.h"
+#include "../logger/Logger.h"
+
+AdaptiveHuffman::AdaptiveHuffman() : counts(256, 1), codes(256), block_size(FIRST_BLOCK_SIZE)
+{
+    // 初始为均匀分布，第一个块每个符号8位
+    rebuild();
+}
+
+void AdaptiveHuffman::rebuild(){
+    std::unordered_map<u8, u64> frequency_map;
+    for(u32 s = 0; s < 256; s++){
+        frequency_map[static_cast<u8>(s)] = counts[s];
+    }
+    tree.reset(new HuffmanTree<u8>());
+    tree->input_data(frequency_map);
+    tree->spawnTree();
+    for(auto &code : tree->get_code_map()){
+        codes[code.first] = code.second;
+    }
+}
+
+void AdaptiveHuffman::update(const u8 *data, size_t size){
+    std::vector<u64> histogram(256, 0);
+    for(size_t i = 0; i < size; i++){
+        histogram[data[i]]++;
+    }
+    for(u32 s = 0; s < 256; s++){
+        u64 count = (counts[s] >> 1) + histogram[s];
+        counts[s] = count > 0 ? count : 1;
+    }
+    if(block_size < BLOCK_SIZE){
+        block_size <<= 1;
+    }
+    rebuild();
+}
+
+void AdaptiveHuffman::encodeBlock(const u8 *data, size_t size, BitWriter &writer){
+    for(size_t i = 0; i < size; i++){
+        const std::pair<u64, u8> &code = codes[data[i]];
+        writer.put(code.first, code.second);
+    }
+    update(data, size);
+}
+
+void AdaptiveHuffman::decodeBlock(BitReader &reader, u8 *out, size_t size){
+    node<u8> *root = tree->get_root();
+    for(size_t i = 0; i < size; i++){
+        // 一次取32位，沿树走到叶子后再按实际码长前进
+        u32 window = reader.peek(32);
+        node<u8> *current = root;
+        u32 length = 0;
+        while(!current->is_leaf){
+            if(length == 32){
+                Logger::getInstance().error("Invalid bit sequence");
+                throw std::runtime_error("Invalid bit sequence");
+            }
+            current = (window >> (31 - length)) & 1 ? current->right_child : current->left_child;
+            length++;
+        }
+        reader.skip(length);
+        out[i] = current->data;
+    }
+    if(reader.overrun()){
+        Logger::getInstance().error("Decoded count not equal to code number");
+        throw std::runtime_error("Decoded count not equal to code number");
+    }
+    update(out, size);
+}
@@ -0,0 +1,44 @@
+#ifndef ADAPTIVEHUFFMAN_H
+#define ADAPTIVEHUFFMAN_H
+
+#include <memory>
+#include <vector>
+#include "huffmantree.h"
+#include "bitio.h"
+
+// 单遍自适应哈夫曼编码
+// 不预先统计频数：每个块用当前码表编码，编码完成后把该块的频数
+// 累加到衰减后的计数上并重建码表，解码端按相同顺序做相同的更新
+class AdaptiveHuffman
+{
+public:
+    // 码表重建间隔（符号数）
+    static constexpr u32 BLOCK_SIZE = 1u << 16;
+
+    // 起始块较小，使小文件也能尽早用上统计，之后逐块翻倍直到BLOCK_SIZE
+    static constexpr u32 FIRST_BLOCK_SIZE = 1u << 10;
+
+    AdaptiveHuffman();
+
+    // 下一个块应包含的符号数，编解码两端按相同的序列切块
+    u32 nextBlockSize() const { return block_size; }
+
+    // 用当前码表编码一个块，然后更新统计
+    void encodeBlock(const u8 *data, size_t size, BitWriter &writer);
+
+    // 解码一个块（size个符号），然后更新统计
+    void decodeBlock(BitReader &reader, u8 *out, size_t size);
+
+private:
+    std::vector<u64> counts;                 // 衰减后的累计频数，所有符号至少为1
+    std::vector<std::pair<u64, u8>> codes;   // 符号 -> (编码, 编码长度)
+    std::unique_ptr<HuffmanTree<u8>> tree;
+    u32 block_size;
+
+    // 计数减半后加上新块的频数，再重建码表
+    void update(const u8 *data, size_t size);
+
+    void rebuild();
+};
+
+#endif // ADAPTIVEHUFFMAN_H
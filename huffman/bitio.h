@@ -0,0 +1,124 @@
+#ifndef BITIO_H
+#define BITIO_H
+
+#include <vector>
+#include <utility>
+
+typedef unsigned char u8;
+typedef unsigned int u32;
+typedef unsigned long long u64;
+
+// 编码size字节输入时位流的预留容量。熵编码的输出一般不超过输入，一次按输入大小预留，
+// 编码途中就不会扩容（扩容时新旧两块缓冲同时存在，并复制已写出的部分）；
+// 预留而没有写到的页不会实际占用物理内存
+inline size_t encode_reserve(u64 size) { return static_cast<size_t>(size + size / 64 + 64); }
+
+// 高位在前的位写入器，与BitStream的位序一致
+class BitWriter
+{
+public:
+    BitWriter() : buffer(0), buffer_bits(0) {}
+
+    // 接在已有的字节之后继续写出
+    explicit BitWriter(std::vector<u8> &&prefix) : bytes(std::move(prefix)), buffer(0), buffer_bits(0) {}
+
+    // 写入value的低nb_bits位（nb_bits <= 56）
+    inline void put(u64 value, u32 nb_bits)
+    {
+        buffer = (buffer << nb_bits) | (value & ((1ull << nb_bits) - 1));
+        buffer_bits += nb_bits;
+        while (buffer_bits >= 8)
+        {
+            buffer_bits -= 8;
+            bytes.push_back(static_cast<u8>(buffer >> buffer_bits));
+        }
+    }
+
+    // 已写入的总位数
+    u64 bitCount() const { return static_cast<u64>(bytes.size()) * 8 + buffer_bits; }
+
+    // 补齐最后不完整的字节并返回结果
+    std::vector<u8> finish()
+    {
+        if (buffer_bits > 0)
+        {
+            bytes.push_back(static_cast<u8>(buffer << (8 - buffer_bits)));
+            buffer_bits = 0;
+        }
+        buffer = 0;
+        return std::move(bytes);
+    }
+
+    void reserve(size_t size) { bytes.reserve(size); }
+
+    // 取走已经凑满的字节，未满一字节的位留在缓冲区（用于边编码边输出）
+    std::vector<u8> takeBytes()
+    {
+        std::vector<u8> result;
+        result.swap(bytes);
+        return result;
+    }
+
+private:
+    std::vector<u8> bytes;
+    u64 buffer;
+    u32 buffer_bits;
+};
+
+// 高位在前的位读取器，超出末尾的位按0读取并记录越界
+class BitReader
+{
+public:
+    BitReader(const u8 *i_data, size_t i_size) : data(i_data), size(i_size), position(0) {}
+
+    // 查看接下来的nb_bits位但不移动（nb_bits <= 32）
+    inline u32 peek(u32 nb_bits) const
+    {
+        size_t byte_pos = static_cast<size_t>(position >> 3);
+        u64 window = 0;
+        if (byte_pos + 8 <= size)
+        {
+            // 大端装载，编译器会将其合并为一次读取加字节交换
+            for (size_t i = 0; i < 8; i++)
+            {
+                window = (window << 8) | data[byte_pos + i];
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < 8; i++)
+            {
+                window <<= 8;
+                if (byte_pos + i < size)
+                {
+                    window |= data[byte_pos + i];
+                }
+            }
+        }
+        window <<= (position & 7);
+        return nb_bits == 0 ? 0 : static_cast<u32>(window >> (64 - nb_bits));
+    }
+
+    inline void skip(u32 nb_bits) { position += nb_bits; }
+
+    inline u32 read(u32 nb_bits)
+    {
+        u32 value = peek(nb_bits);
+        position += nb_bits;
+        return value;
+    }
+
+    u64 tell() const { return position; }
+
+    u64 bitSize() const { return static_cast<u64>(size) * 8; }
+
+    // 是否读到了位流末尾之后
+    bool overrun() const { return position > bitSize(); }
+
+private:
+    const u8 *data;
+    size_t size;
+    u64 position;
+};
+
+#endif // BITIO_H
@@ -1,8 +1,10 @@
 #ifndef BITSTREAM_H
 #define BITSTREAM_H
 
+#include <algorithm>
 #include <unordered_map>
 #include "huffmantree.h"
+#include "bitio.h"
 #include "../logger/Logger.h"
 
 template <typename T>
@@ -26,22 +28,28 @@ public:
 
     // 编码模式，也可以做解码模式
 
-    std::vector<T> decode(std::vector<u8> bytes, u64 code_num)
+    // 解码到调用者提供的code_num个元素的内存，位流只读不复制
+    void decodeInto(const u8 *bytes, u64 size, T *out, u64 code_num)
     {
-        std::vector<T> result;
-        result.reserve(code_num);
-
         if (root == nullptr)
         {
             throw std::runtime_error("Huffman tree root is null");
         }
 
+        // 只有一种符号时编码长度为0，位流为空
+        if (root->is_leaf)
+        {
+            std::fill(out, out + code_num, root->data);
+            return;
+        }
+
         node<T> *current = root;
         u64 decoded_count = 0;
 
         // 遍历每个字节
-        for (const u8 &byte : bytes)
+        for (u64 index = 0; index < size; index++)
         {
+            const u8 byte = bytes[index];
             // 从最高位到最低位处理每个bit
             for (int i = 7; i >= 0 && decoded_count < code_num; i--)
             {
@@ -61,7 +69,7 @@ public:
                 // 检查是否到达叶节点
                 if (current != nullptr && current->is_leaf)
                 {
-                    result.push_back(current->data);
+                    out[decoded_count] = current->data;
                     decoded_count++;
                     current = root; // 回到根节点继续解码
                 }else if (current == nullptr){
@@ -81,20 +89,32 @@ public:
             Logger::getInstance().error("Decoded count not equal to code number");
             throw std::runtime_error("Decoded count not equal to code number");
         }
+    }
 
+    std::vector<T> decode(const u8 *bytes, u64 size, u64 code_num)
+    {
+        std::vector<T> result(code_num);
+        decodeInto(bytes, size, result.data(), code_num);
         return result;
     }
 
-    std::vector<u8> encode(std::vector<T> data)
+    std::vector<T> decode(const std::vector<u8> &bytes, u64 code_num)
+    {
+        return decode(bytes.data(), bytes.size(), code_num);
+    }
+
+    std::vector<u8> encode(const T *data, u64 size)
     {
         std::vector<u8> result;
+        result.reserve(encode_reserve(size * sizeof(T)));
 
         u8 buffer = 0;      // 位缓冲区
         u8 buffer_bits = 0; // 缓冲区中已使用的位数
 
         // 处理每个数据元素
-        for (const T &item : data)
+        for (u64 index = 0; index < size; index++)
         {
+            const T &item = data[index];
             // 查找该数据的编码
             auto it = code_map.find(item);
             if (it == code_map.end())
@@ -134,6 +154,11 @@ public:
         return result;
     }
 
+    std::vector<u8> encode(const std::vector<T> &data)
+    {
+        return encode(data.data(), data.size());
+    }
+
 private:
     std::unordered_map<T, std::pair<u64, u8>> code_map; // 编码，编码长度
 
@@ -0,0 +1,324 @@
+#include "blockhuffman.h"
+#include "bitio.h"
+#include "../logger/Logger.h"
+#include <cmath>
+#include <limits>
+
+// 码表中每个符号的存储开销：键2字节 + 值按2字节估算
+static constexpr double TABLE_ENTRY_BITS = 4 * 8;
+
+static u64 total_of(const std::vector<u64> &histogram){
+    u64 total = 0;
+    for(u64 count : histogram){
+        total += count;
+    }
+    return total;
+}
+
+// 用直方图自身的分布编码的经验熵（位）
+static double entropy_bits(const std::vector<u64> &histogram){
+    u64 total = total_of(histogram);
+    double bits = 0;
+    for(u64 count : histogram){
+        if(count > 0){
+            bits += count * std::log2(static_cast<double>(total) / count);
+        }
+    }
+    return bits;
+}
+
+// 用table的分布编码histogram的位数；table中没有的符号按最低概率计，并加上补进码表的开销
+static double cross_bits(const std::vector<u64> &histogram, const std::vector<u64> &table){
+    double table_total = static_cast<double>(total_of(table) + 1);
+    double bits = 0;
+    for(u32 s = 0; s < 256; s++){
+        if(histogram[s] == 0){
+            continue;
+        }
+        if(table[s] > 0){
+            bits += histogram[s] * std::log2(table_total / table[s]);
+        }else{
+            bits += histogram[s] * std::log2(table_total) + TABLE_ENTRY_BITS;
+        }
+    }
+    return bits;
+}
+
+static double table_bits(const std::vector<u64> &histogram){
+    double bits = 0;
+    for(u64 count : histogram){
+        bits += count > 0 ? TABLE_ENTRY_BITS : 0;
+    }
+    return bits;
+}
+
+static void accumulate(std::vector<u64> &into, const std::vector<u64> &from){
+    for(u32 s = 0; s < 256; s++){
+        into[s] += from[s];
+    }
+}
+
+BlockHuffman::BlockHuffman(const u8 *data, u64 size){
+    if(size == 0){
+        Logger::getInstance().error("Empty data");
+        throw std::runtime_error("Empty data");
+    }
+    u64 segment_count = (size + SEGMENT_SIZE - 1) / SEGMENT_SIZE;
+
+    // 1. 贪心切分：新段并入当前块的熵增加超过切分开销时另起一块
+    struct Range
+    {
+        u64 segments;
+        std::vector<u64> histogram;
+        u32 table;
+    };
+    std::vector<Range> ranges;
+    std::vector<u64> segment(256);
+    for(u64 seg = 0; seg < segment_count; seg++){
+        std::fill(segment.begin(), segment.end(), 0);
+        u64 end = std::min<u64>((seg + 1) * SEGMENT_SIZE, size);
+        for(u64 i = seg * SEGMENT_SIZE; i < end; i++){
+            segment[data[i]]++;
+        }
+        if(!ranges.empty()){
+            Range &current = ranges.back();
+            std::vector<u64> merged(current.histogram);
+            accumulate(merged, segment);
+            double increase = entropy_bits(merged) - entropy_bits(current.histogram) - entropy_bits(segment);
+            if(increase <= SPLIT_PENALTY_BITS){
+                current.histogram.swap(merged);
+                current.segments++;
+                continue;
+            }
+        }
+        ranges.push_back(Range{1, segment, 0});
+    }
+
+    // 2. 依次为每个块选择码表：沿用已有的共享码表，或在未达上限时新建一张
+    std::vector<std::vector<u64>> tables;
+    for(Range &range : ranges){
+        double best_bits = std::numeric_limits<double>::max();
+        u32 best = 0;
+        for(u32 t = 0; t < tables.size(); t++){
+            double bits = cross_bits(range.histogram, tables[t]);
+            if(bits < best_bits){
+                best_bits = bits;
+                best = t;
+            }
+        }
+        if(tables.size() < MAX_TABLES && entropy_bits(range.histogram) + table_bits(range.histogram) < best_bits){
+            best = static_cast<u32>(tables.size());
+            tables.push_back(std::vector<u64>(256, 0));
+        }
+        range.table = best;
+        accumulate(tables[best], range.histogram);
+    }
+
+    // 3. 码表确定后按实际分布重新分配一次，再用分配结果重新统计码表
+    std::vector<std::vector<u64>> refined(tables.size(), std::vector<u64>(256, 0));
+    for(Range &range : ranges){
+        double best_bits = cross_bits(range.histogram, tables[range.table]);
+        for(u32 t = 0; t < tables.size(); t++){
+            double bits = cross_bits(range.histogram, tables[t]);
+            if(bits < best_bits){
+                best_bits = bits;
+                range.table = t;
+            }
+        }
+        accumulate(refined[range.table], range.histogram);
+    }
+    std::vector<u32> remap(tables.size(), 0);
+    std::vector<std::vector<u64>> histograms;
+    double split_bits = 0;
+    for(u32 t = 0; t < refined.size(); t++){
+        if(total_of(refined[t]) > 0){
+            remap[t] = static_cast<u32>(histograms.size());
+            histograms.push_back(refined[t]);
+            split_bits += entropy_bits(refined[t]) + table_bits(refined[t]);
+        }
+    }
+
+    // 分块的估算总大小不如单张码表时退化为一个块
+    std::vector<u64> whole(256, 0);
+    for(const auto &histogram : histograms){
+        accumulate(whole, histogram);
+    }
+    if(histograms.size() > 1 && entropy_bits(whole) + table_bits(whole) <= split_bits){
+        histograms.assign(1, whole);
+        std::fill(remap.begin(), remap.end(), 0);
+    }
+
+    // 4. 合并相邻且码表相同的块
+    for(const Range &range : ranges){
+        u8 table = static_cast<u8>(remap[range.table]);
+        if(!blocks.empty() && blocks.back().table == table){
+            blocks.back().segments += range.segments;
+        }else{
+            blocks.push_back(Block{range.segments, table});
+        }
+    }
+    Logger::getInstance().debug("分块数: " + std::to_string(blocks.size()) + ", 共享码表数: " + std::to_string(histograms.size()));
+    // 频数悬殊时码长可能超过查表解码的上限，压平该码表的频数后再建表
+    for(auto &histogram : histograms){
+        if(limit_code_length<u8>(histogram, TABLE_CODE_BITS)){
+            Logger::getInstance().debug("分块码表码长超过 " + std::to_string(TABLE_CODE_BITS) + " 位，已压平频数");
+        }
+    }
+    build(histograms);
+}
+
+BlockHuffman::BlockHuffman(const std::unordered_map<u64, u64> &frequency_map){
+    std::vector<std::vector<u64>> histograms;
+    for(const auto &entry : frequency_map){
+        u64 table = entry.first >> 8;
+        if(table >= MAX_TABLES){
+            Logger::getInstance().error("Invalid table in frequency map");
+            throw std::runtime_error("Invalid table in frequency map");
+        }
+        if(table >= histograms.size()){
+            histograms.resize(table + 1, std::vector<u64>(256, 0));
+        }
+        histograms[table][entry.first & 0xFF] = entry.second;
+    }
+    build(histograms);
+}
+
+void BlockHuffman::build(const std::vector<std::vector<u64>> &histograms){
+    trees.clear();
+    lookups.clear();
+    codes.assign(histograms.size(), std::vector<std::pair<u64, u8>>(256, std::make_pair(0, 0)));
+    for(size_t t = 0; t < histograms.size(); t++){
+        std::unordered_map<u8, u64> frequency_map;
+        for(u32 s = 0; s < 256; s++){
+            if(histograms[t][s] > 0){
+                frequency_map[static_cast<u8>(s)] = histograms[t][s];
+            }
+        }
+        if(frequency_map.empty()){
+            trees.emplace_back();
+            lookups.emplace_back();
+            continue;
+        }
+        std::unique_ptr<HuffmanTree<u8>> tree(new HuffmanTree<u8>());
+        tree->input_data(frequency_map);
+        tree->spawnTree();
+        for(auto &code : tree->get_code_map()){
+            if(code.second.second > TABLE_CODE_BITS){
+                Logger::getInstance().error("Huffman code longer than 32 bits");
+                throw std::runtime_error("Huffman code longer than 32 bits");
+            }
+            codes[t][code.first] = code.second;
+        }
+        lookups.emplace_back(new HuffmanLookup<u8>(tree->get_root()));
+        trees.push_back(std::move(tree));
+    }
+}
+
+std::vector<u8> BlockHuffman::encode(const u8 *data, u64 size) const {
+    BitWriter writer;
+    writer.reserve(encode_reserve(size) + blocks.size() * 4);
+
+    u32 block_count = static_cast<u32>(blocks.size());
+    for(int b = 0; b < 4; b++){
+        writer.put((block_count >> (8 * b)) & 0xFF, 8);
+    }
+    for(const Block &block : blocks){
+        u64 segments = block.segments;
+        do{
+            u8 byte = segments & 0x7F;
+            segments >>= 7;
+            writer.put(segments ? (byte | 0x80) : byte, 8);
+        }while(segments);
+        writer.put(block.table, 8);
+    }
+
+    u64 offset = 0;
+    for(const Block &block : blocks){
+        u64 end = std::min<u64>(offset + block.segments * SEGMENT_SIZE, size);
+        const std::vector<std::pair<u64, u8>> &table = codes[block.table];
+        for(; offset < end; offset++){
+            const std::pair<u64, u8> &code = table[data[offset]];
+            writer.put(code.first, code.second);
+        }
+    }
+    return writer.finish();
+}
+
+void BlockHuffman::decodeInto(const u8 *bytes, u64 size, u8 *out, u64 code_num) const {
+    auto invalid = [](){
+        Logger::getInstance().error("Invalid block directory");
+        throw std::runtime_error("Invalid block directory");
+    };
+    size_t position = 0;
+    if(size < 4){
+        invalid();
+    }
+    u32 block_count = 0;
+    for(int b = 3; b >= 0; b--){
+        block_count = (block_count << 8) | bytes[b];
+    }
+    position = 4;
+
+    std::vector<Block> directory;
+    for(u32 i = 0; i < block_count; i++){
+        u64 segments = 0;
+        for(u32 shift = 0;; shift += 7){
+            if(position >= size || shift > 56){
+                invalid();
+            }
+            u8 byte = bytes[position++];
+            segments |= static_cast<u64>(byte & 0x7F) << shift;
+            if(!(byte & 0x80)){
+                break;
+            }
+        }
+        if(position >= size){
+            invalid();
+        }
+        u8 table = bytes[position++];
+        if(table >= lookups.size() || !lookups[table]){
+            invalid();
+        }
+        directory.push_back(Block{segments, table});
+    }
+
+    BitReader reader(bytes + position, size - position);
+    u64 offset = 0;
+    for(const Block &block : directory){
+        if(block.segments > (code_num - offset + SEGMENT_SIZE - 1) / SEGMENT_SIZE){
+            invalid();
+        }
+        u64 end = std::min<u64>(offset + block.segments * SEGMENT_SIZE, code_num);
+        const HuffmanLookup<u8> &lookup = *lookups[block.table];
+        for(; offset < end; offset++){
+            out[offset] = lookup.decode(reader);
+        }
+    }
+    if(offset != code_num || reader.overrun() || (reader.bitSize() - reader.tell()) >= 8){
+        Logger::getInstance().error("Decoded count not equal to code number");
+        throw std::runtime_error("Decoded count not equal to code number");
+    }
+}
+
+std::unordered_map<u64, u64> BlockHuffman::get_frequency_map() const {
+    std::unordered_map<u64, u64> frequency_map;
+    for(size_t t = 0; t < trees.size(); t++){
+        if(!trees[t]){
+            continue;
+        }
+        for(auto &entry : trees[t]->get_frequency_map()){
+            frequency_map[(static_cast<u64>(t) << 8) | entry.first] = entry.second;
+        }
+    }
+    return frequency_map;
+}
+
+u8 BlockHuffman::get_frequency_length() const {
+    u8 length = 1;
+    for(const auto &tree : trees){
+        if(tree && tree->get_frequency_length() > length){
+            length = tree->get_frequency_length();
+        }
+    }
+    return length;
+}
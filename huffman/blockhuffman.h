@@ -0,0 +1,68 @@
+#ifndef BLOCKHUFFMAN_H
+#define BLOCKHUFFMAN_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "huffmantree.h"
+#include "huffmanlookup.h"
+
+// 自适应分块哈夫曼编码
+// 编码端按固定大小的分析段统计直方图，在统计发生变化处切分块；
+// 每个块从少量聚类得到的共享码表中选择一张，相邻且选中同一张表的块合并，
+// 因此“沿用上一张表”不产生任何额外开销，也不必为每个块单独保存码表
+class BlockHuffman
+{
+public:
+    // 分析段大小，块边界只会落在段边界上
+    static constexpr u32 SEGMENT_SIZE = 4096;
+
+    // 共享码表数量上限
+    static constexpr u32 MAX_TABLES = 16;
+
+    // 新切出一个块的估算开销（位），抑制过细的切分
+    static constexpr u32 SPLIT_PENALTY_BITS = 1024;
+
+    // 编码端：切分块并聚类码表
+    BlockHuffman(const u8 *data, u64 size);
+    explicit BlockHuffman(const std::vector<u8> &data) : BlockHuffman(data.data(), data.size()) {}
+
+    // 解码端：键为 (码表编号 << 8) | 符号
+    explicit BlockHuffman(const std::unordered_map<u64, u64> &frequency_map);
+
+    // 输出：块目录 + 位流
+    // 块目录为 块数(u32小端)，随后每块 段数(LEB128变长) + 码表编号(1字节)
+    std::vector<u8> encode(const u8 *data, u64 size) const;
+    std::vector<u8> encode(const std::vector<u8> &data) const { return encode(data.data(), data.size()); }
+
+    void decodeInto(const u8 *bytes, u64 size, u8 *out, u64 code_num) const;
+    std::vector<u8> decode(const std::vector<u8> &bytes, u64 code_num) const {
+        std::vector<u8> result(code_num);
+        decodeInto(bytes.data(), bytes.size(), result.data(), code_num);
+        return result;
+    }
+
+    std::unordered_map<u64, u64> get_frequency_map() const;
+
+    u8 get_frequency_length() const;
+
+    u32 get_table_count() const { return static_cast<u32>(trees.size()); }
+
+    u32 get_block_count() const { return static_cast<u32>(blocks.size()); }
+
+private:
+    struct Block
+    {
+        u64 segments; // 块包含的分析段数，最后一段可能不满
+        u8 table;
+    };
+
+    std::vector<Block> blocks;  // 仅编码端使用
+    std::vector<std::unique_ptr<HuffmanTree<u8>>> trees;
+    std::vector<std::unique_ptr<HuffmanLookup<u8>>> lookups;
+    std::vector<std::vector<std::pair<u64, u8>>> codes;
+
+    void build(const std::vector<std::vector<u64>> &histograms);
+};
+
+#endif // BLOCKHUFFMAN_H
@@ -0,0 +1,61 @@
+#ifndef BMPLAYOUT_H
+#define BMPLAYOUT_H
+
+typedef unsigned char u8;
+typedef unsigned int u32;
+typedef unsigned long long u64;
+
+// 从BMP文件头解析出的像素排布
+// 只依赖前54字节，解码端在还原出文件头后即可得到与编码端相同的结果
+struct BmpLayout
+{
+    static constexpr u64 HEADER_BYTES = 54; // 文件头+信息头
+
+    u64 offset = HEADER_BYTES; // 像素数据起始位置
+    u32 pixel_bytes = 1;       // 每像素字节数（不足1字节按1计）
+    u64 row_bytes = 0;         // 每行字节数（含4字节对齐），0表示未知
+    u32 bit_count = 0;         // 每像素位数
+    int width = 0;
+    int height = 0;            // 负数表示自上而下存储
+
+    bool valid() const { return row_bytes != 0; }
+
+    static u32 readLE(const u8 *p, int bytes)
+    {
+        u32 value = 0;
+        for (int i = bytes - 1; i >= 0; i--)
+        {
+            value = (value << 8) | p[i];
+        }
+        return value;
+    }
+
+    // size为整个文件的大小，不是BMP或字段不合法时返回默认排布
+    static BmpLayout parse(const u8 *data, u64 size)
+    {
+        BmpLayout layout;
+        if (size < HEADER_BYTES || data[0] != 'B' || data[1] != 'M')
+        {
+            return layout;
+        }
+        u64 offset = readLE(data + 10, 4);
+        int width = static_cast<int>(readLE(data + 18, 4));
+        int height = static_cast<int>(readLE(data + 22, 4));
+        u32 bit_count = readLE(data + 28, 2);
+        bool valid_depth = bit_count == 1 || bit_count == 4 || bit_count == 8 ||
+                           bit_count == 16 || bit_count == 24 || bit_count == 32;
+        if (!valid_depth || offset < HEADER_BYTES || offset > size || width <= 0 || width >= (1 << 24))
+        {
+            return layout;
+        }
+        layout.offset = offset;
+        layout.pixel_bytes = bit_count >= 8 ? bit_count / 8 : 1;
+        layout.row_bytes = ((static_cast<u64>(width) * bit_count + 31) / 32) * 4;
+        layout.bit_count = bit_count;
+        layout.width = width;
+        layout.height = height;
+        return layout;
+    }
+};
+
+#endif // BMPLAYOUT_H
@@ -0,0 +1,200 @@
+#include "contexthuffman.h"
+#include "bitio.h"
+#include "bmplayout.h"
+#include "../logger/Logger.h"
+#include <cmath>
+
+// 每张码表在文件中的开销：每个符号一个(键, 频数)对，按3字节估算
+static constexpr double TABLE_ENTRY_BITS = 3 * 8;
+
+template <typename F>
+void ContextHuffman::forEachContext(const u8 *data, u64 size, u8 context_bits, F &&f){
+    const u32 shift = 8 - context_bits;
+
+    // 文件头：前一个字节
+    u64 i = 0;
+    u64 header_end = size < BmpLayout::HEADER_BYTES ? size : BmpLayout::HEADER_BYTES;
+    for(; i < header_end; i++){
+        f(i, i > 0 ? data[i - 1] >> shift : 0);
+    }
+    if(i == size){
+        return;
+    }
+
+    BmpLayout layout = BmpLayout::parse(data, size);
+    for(; i < layout.offset && i < size; i++){
+        f(i, data[i - 1] >> shift);
+    }
+
+    // 像素数据：同通道左侧像素与上一行像素的均值
+    const u32 pb = layout.pixel_bytes;
+    const u64 rb = layout.row_bytes;
+    u64 col = 0, row = 0;
+    for(; i < size; i++){
+        u32 left = col >= pb ? data[i - pb] : data[i - 1];
+        u32 value = row > 0 ? (left + data[i - rb] + 1) >> 1 : left;
+        f(i, value >> shift);
+
+        if(rb != 0 && ++col == rb){
+            col = 0;
+            row++;
+        }else if(rb == 0){
+            col++;
+        }
+    }
+}
+
+// 按经验熵估算一张码表编码数据的位数，加上码表本身的开销
+static double estimate_bits(const std::vector<u64> &histogram){
+    u64 total = 0;
+    u32 symbols = 0;
+    for(u64 count : histogram){
+        total += count;
+        symbols += count > 0;
+    }
+    if(total == 0){
+        return 0;
+    }
+    double bits = 0;
+    for(u64 count : histogram){
+        if(count > 0){
+            bits += count * std::log2(static_cast<double>(total) / count);
+        }
+    }
+    return bits + symbols * TABLE_ENTRY_BITS;
+}
+
+ContextHuffman::ContextHuffman(const u8 *data, u64 size) : context_bits(0){
+    const u32 max_contexts = 1u << MAX_CONTEXT_BITS;
+    std::vector<std::vector<u64>> fine(max_contexts, std::vector<u64>(256, 0));
+    forEachContext(data, size, MAX_CONTEXT_BITS, [&](u64 i, u32 ctx){
+        fine[ctx][data[i]]++;
+    });
+
+    // 桶是按高位划分的，位数较少时直接合并相邻的细分桶
+    std::vector<std::vector<u64>> best;
+    double best_bits = 0;
+    for(u8 bits = 0; bits <= MAX_CONTEXT_BITS; bits++){
+        u32 merge = MAX_CONTEXT_BITS - bits;
+        std::vector<std::vector<u64>> histograms(1u << bits, std::vector<u64>(256, 0));
+        for(u32 ctx = 0; ctx < max_contexts; ctx++){
+            for(u32 s = 0; s < 256; s++){
+                histograms[ctx >> merge][s] += fine[ctx][s];
+            }
+        }
+        double total_bits = 0;
+        for(const auto &histogram : histograms){
+            total_bits += estimate_bits(histogram);
+        }
+        if(bits == 0 || total_bits < best_bits){
+            best_bits = total_bits;
+            best = std::move(histograms);
+            context_bits = bits;
+        }
+    }
+    Logger::getInstance().debug("上下文位数: " + std::to_string(context_bits));
+    // 频数悬殊时码长可能超过查表解码的上限，压平该上下文的频数后再建表
+    for(auto &histogram : best){
+        if(limit_code_length<u8>(histogram, TABLE_CODE_BITS)){
+            Logger::getInstance().debug("上下文码表码长超过 " + std::to_string(TABLE_CODE_BITS) + " 位，已压平频数");
+        }
+    }
+    build(best);
+}
+
+ContextHuffman::ContextHuffman(u8 context_bits, const std::unordered_map<u64, u64> &frequency_map) : context_bits(context_bits){
+    if(context_bits > MAX_CONTEXT_BITS){
+        Logger::getInstance().error("Invalid context bits: " + std::to_string(context_bits));
+        throw std::runtime_error("Invalid context bits");
+    }
+    std::vector<std::vector<u64>> histograms(1u << context_bits, std::vector<u64>(256, 0));
+    for(const auto &entry : frequency_map){
+        u64 ctx = entry.first >> 8;
+        if(ctx >= histograms.size()){
+            Logger::getInstance().error("Invalid context in frequency map");
+            throw std::runtime_error("Invalid context in frequency map");
+        }
+        histograms[ctx][entry.first & 0xFF] = entry.second;
+    }
+    build(histograms);
+}
+
+void ContextHuffman::build(const std::vector<std::vector<u64>> &histograms){
+    trees.clear();
+    lookups.clear();
+    codes.assign(histograms.size(), std::vector<std::pair<u64, u8>>(256, std::make_pair(0, 0)));
+    for(size_t ctx = 0; ctx < histograms.size(); ctx++){
+        std::unordered_map<u8, u64> frequency_map;
+        for(u32 s = 0; s < 256; s++){
+            if(histograms[ctx][s] > 0){
+                frequency_map[static_cast<u8>(s)] = histograms[ctx][s];
+            }
+        }
+        if(frequency_map.empty()){
+            trees.emplace_back();
+            lookups.emplace_back();
+            continue;
+        }
+        std::unique_ptr<HuffmanTree<u8>> tree(new HuffmanTree<u8>());
+        tree->input_data(frequency_map);
+        tree->spawnTree();
+        for(auto &code : tree->get_code_map()){
+            if(code.second.second > TABLE_CODE_BITS){
+                Logger::getInstance().error("Huffman code longer than 32 bits");
+                throw std::runtime_error("Huffman code longer than 32 bits");
+            }
+            codes[ctx][code.first] = code.second;
+        }
+        lookups.emplace_back(new HuffmanLookup<u8>(tree->get_root()));
+        trees.push_back(std::move(tree));
+    }
+}
+
+std::vector<u8> ContextHuffman::encode(const u8 *data, u64 size) const {
+    BitWriter writer;
+    writer.reserve(encode_reserve(size));
+    forEachContext(data, size, context_bits, [&](u64 i, u32 ctx){
+        const std::pair<u64, u8> &code = codes[ctx][data[i]];
+        writer.put(code.first, code.second);
+    });
+    return writer.finish();
+}
+
+void ContextHuffman::decodeInto(const u8 *bytes, u64 size, u8 *out, u64 code_num) const {
+    BitReader reader(bytes, size);
+    forEachContext(out, code_num, context_bits, [&](u64 i, u32 ctx){
+        const HuffmanLookup<u8> *lookup = lookups[ctx].get();
+        if(lookup == nullptr){
+            Logger::getInstance().error("Context without code table: " + std::to_string(ctx));
+            throw std::runtime_error("Context without code table");
+        }
+        out[i] = lookup->decode(reader);
+    });
+    if(reader.overrun() || (reader.bitSize() - reader.tell()) >= 8){
+        Logger::getInstance().error("Decoded count not equal to code number");
+        throw std::runtime_error("Decoded count not equal to code number");
+    }
+}
+
+std::unordered_map<u64, u64> ContextHuffman::get_frequency_map() const {
+    std::unordered_map<u64, u64> frequency_map;
+    for(size_t ctx = 0; ctx < trees.size(); ctx++){
+        if(!trees[ctx]){
+            continue;
+        }
+        for(auto &entry : trees[ctx]->get_frequency_map()){
+            frequency_map[(static_cast<u64>(ctx) << 8) | entry.first] = entry.second;
+        }
+    }
+    return frequency_map;
+}
+
+u8 ContextHuffman::get_frequency_length() const {
+    u8 length = 1;
+    for(const auto &tree : trees){
+        if(tree && tree->get_frequency_length() > length){
+            length = tree->get_frequency_length();
+        }
+    }
+    return length;
+}
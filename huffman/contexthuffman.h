@@ -0,0 +1,57 @@
+#ifndef CONTEXTHUFFMAN_H
+#define CONTEXTHUFFMAN_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "huffmantree.h"
+#include "huffmanlookup.h"
+
+// 上下文哈夫曼编码
+// 每个字节按相邻像素（同通道左侧与上一行的均值）分桶，
+// 每个桶使用一棵独立的HuffmanTree<u8>，共2^context_bits张码表
+class ContextHuffman
+{
+public:
+    static constexpr u8 MAX_CONTEXT_BITS = 4;
+
+    // 编码端：统计各上下文的频数，按估算总大小选择上下文位数并建表
+    ContextHuffman(const u8 *data, u64 size);
+    explicit ContextHuffman(const std::vector<u8> &data) : ContextHuffman(data.data(), data.size()) {}
+
+    // 解码端：由文件中保存的频数表重建，键为 (上下文 << 8) | 符号
+    ContextHuffman(u8 context_bits, const std::unordered_map<u64, u64> &frequency_map);
+
+    std::vector<u8> encode(const u8 *data, u64 size) const;
+    std::vector<u8> encode(const std::vector<u8> &data) const { return encode(data.data(), data.size()); }
+
+    // 解码code_num字节写入out，上下文取自out中已解出的数据
+    void decodeInto(const u8 *bytes, u64 size, u8 *out, u64 code_num) const;
+    std::vector<u8> decode(const std::vector<u8> &bytes, u64 code_num) const {
+        std::vector<u8> result(code_num);
+        decodeInto(bytes.data(), bytes.size(), result.data(), code_num);
+        return result;
+    }
+
+    u8 get_context_bits() const { return context_bits; }
+
+    // 所有上下文的频数表，键为 (上下文 << 8) | 符号
+    std::unordered_map<u64, u64> get_frequency_map() const;
+
+    // 频数所需的最大字节数
+    u8 get_frequency_length() const;
+
+private:
+    u8 context_bits;
+    std::vector<std::unique_ptr<HuffmanTree<u8>>> trees;          // 上下文 -> 码树（未出现的上下文为空）
+    std::vector<std::unique_ptr<HuffmanLookup<u8>>> lookups;      // 上下文 -> 解码表
+    std::vector<std::vector<std::pair<u64, u8>>> codes;           // 上下文 -> 符号 -> (编码, 编码长度)
+
+    void build(const std::vector<std::vector<u64>> &histograms);
+
+    // 按顺序遍历每个位置并给出其上下文，只依赖该位置之前的数据
+    template <typename F>
+    static void forEachContext(const u8 *data, u64 size, u8 context_bits, F &&f);
+};
+
+#endif // CONTEXTHUFFMAN_H
@@ -0,0 +1,86 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <cstddef>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+typedef unsigned char u8;
+typedef unsigned long long u64;
+
+// 参考帧差分：残差 = 当前 - 参考（模256），还原时 当前 = 残差 + 参考
+// out可以与data/residual相同，原地计算
+namespace Delta
+{
+    inline void subtract(u8 *out, const u8 *data, const u8 *ref, size_t size)
+    {
+        size_t i = 0;
+#if defined(__SSE2__)
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ref + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_sub_epi8(a, b));
+        }
+#endif
+        for (; i < size; i++)
+        {
+            out[i] = static_cast<u8>(data[i] - ref[i]);
+        }
+    }
+
+    inline void add(u8 *out, const u8 *residual, const u8 *ref, size_t size)
+    {
+        size_t i = 0;
+#if defined(__SSE2__)
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(residual + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ref + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_add_epi8(a, b));
+        }
+#endif
+        for (; i < size; i++)
+        {
+            out[i] = static_cast<u8>(residual[i] + ref[i]);
+        }
+    }
+
+    // 参考图像指纹（FNV-1a 64位），解码前用于确认拿到的是同一个参考
+    inline u64 fingerprint(const u8 *data, size_t size)
+    {
+        u64 hash = 14695981039346656037ull;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= data[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // 位集开头的参考描述：指纹(8B) + 参考长度(8B)，均为小端
+    constexpr size_t DESCRIPTOR_SIZE = 16;
+
+    inline void writeDescriptor(u8 *out, u64 fingerprint, u64 size)
+    {
+        for (int b = 0; b < 8; b++)
+        {
+            out[b] = static_cast<u8>(fingerprint >> (8 * b));
+            out[8 + b] = static_cast<u8>(size >> (8 * b));
+        }
+    }
+
+    inline void readDescriptor(const u8 *in, u64 &fingerprint, u64 &size)
+    {
+        fingerprint = 0;
+        size = 0;
+        for (int b = 7; b >= 0; b--)
+        {
+            fingerprint = (fingerprint << 8) | in[b];
+            size = (size << 8) | in[8 + b];
+        }
+    }
+}
+
+#endif // DELTA_H
@@ -0,0 +1,112 @@
+#ifndef HUFFMANLOOKUP_H
+#define HUFFMANLOOKUP_H
+
+#include <algorithm>
+#include <vector>
+#include <stdexcept>
+#include "huffmantree.h"
+#include "bitio.h"
+#include "../logger/Logger.h"
+
+// 查表解码哈夫曼编码：用接下来的LOOKUP_BITS位直接查出符号和码长，
+// 更长的编码从表项记录的节点继续逐位走树。按字节编码时不限制码长，
+// 超过32位的编码（频数悬殊时才会出现）先走完窥视窗口中的32位，其余逐位读取
+template <typename T>
+class HuffmanLookup
+{
+public:
+    static constexpr u32 LOOKUP_BITS = 10;
+
+    // root由对应的HuffmanTree持有，需保证其生命周期长于本对象
+    explicit HuffmanLookup(node<T> *root) : table(1u << LOOKUP_BITS)
+    {
+        if (root == nullptr)
+        {
+            throw std::runtime_error("Huffman tree root is null");
+        }
+        for (u32 v = 0; v < table.size(); v++)
+        {
+            node<T> *current = root;
+            u8 depth = 0;
+            while (!current->is_leaf && depth < LOOKUP_BITS)
+            {
+                u32 bit = (v >> (LOOKUP_BITS - 1 - depth)) & 1;
+                current = bit ? current->right_child : current->left_child;
+                depth++;
+            }
+            Entry &entry = table[v];
+            entry.leaf = current->is_leaf;
+            entry.length = current->is_leaf ? depth : 0;
+            entry.symbol = current->is_leaf ? current->data : T();
+            entry.next = current->is_leaf ? nullptr : current;
+        }
+        measure(root);
+    }
+
+    inline T decode(BitReader &reader) const
+    {
+        u32 window = reader.peek(32);
+        const Entry &entry = table[window >> (32 - LOOKUP_BITS)];
+        if (entry.leaf)
+        {
+            reader.skip(entry.length);
+            return entry.symbol;
+        }
+        node<T> *current = entry.next;
+        u32 length = LOOKUP_BITS;
+        while (!current->is_leaf && length < 32)
+        {
+            current = (window >> (31 - length)) & 1 ? current->right_child : current->left_child;
+            length++;
+        }
+        reader.skip(length);
+        while (!current->is_leaf)
+        {
+            current = reader.read(1) ? current->right_child : current->left_child;
+        }
+        return current->data;
+    }
+
+    // 连续解码count个符号写入out，调用方检查reader是否越界
+    void decodeInto(BitReader &reader, T *out, u64 count) const
+    {
+        for (u64 i = 0; i < count; i++)
+        {
+            out[i] = decode(reader);
+        }
+    }
+
+    // 最长码长，位流中至少剩下这么多位时解码一个符号不会读到末尾之后
+    u32 max_length() const { return longest; }
+
+private:
+    struct Entry
+    {
+        T symbol;
+        u8 length;
+        bool leaf;
+        node<T> *next;
+    };
+
+    std::vector<Entry> table;
+    u32 longest = 0;
+
+    void measure(node<T> *root)
+    {
+        std::vector<std::pair<node<T> *, u32>> stack(1, std::make_pair(root, 0u));
+        while (!stack.empty())
+        {
+            std::pair<node<T> *, u32> top = stack.back();
+            stack.pop_back();
+            if (top.first->is_leaf)
+            {
+                longest = std::max(longest, top.second);
+                continue;
+            }
+            stack.push_back(std::make_pair(top.first->left_child, top.second + 1));
+            stack.push_back(std::make_pair(top.first->right_child, top.second + 1));
+        }
+    }
+};
+
+#endif // HUFFMANLOOKUP_H
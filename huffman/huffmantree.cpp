@@ -29,7 +29,7 @@ inline int format_code_length(u64 code_length){
 
 
 template <typename T>
-HuffmanTree<T>::HuffmanTree() : isUpdateRoot(false), handled_count_twice(0){};
+HuffmanTree<T>::HuffmanTree() : handled_count_twice(0), root(nullptr), isUpdateRoot(false){};
 
 template <typename T>
 HuffmanTree<T>::~HuffmanTree(){
@@ -200,7 +200,7 @@ std::priority_queue<node<T> *, std::vector<node<T> *>, NodePtrCompare<T>> Huffma
 }
 
 template <typename T>
-std::unordered_map<T, u64> HuffmanTree<T>::get_frequency_map() const {
+const std::unordered_map<T, u64> &HuffmanTree<T>::get_frequency_map() const {
     return frequency_map;
 }
 
@@ -220,7 +220,7 @@ u8 HuffmanTree<T>::get_frequency_length(){
 }
 
 template <typename T>
-std::unordered_map<T, std::pair<u64, u8>> HuffmanTree<T>::get_code_map() const {
+const std::unordered_map<T, std::pair<u64, u8>> &HuffmanTree<T>::get_code_map() const {
     return code_map;
 }
 
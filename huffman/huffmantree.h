@@ -141,9 +141,10 @@ public:
     // 获取编码
     std::pair<u64, u8> getCode(T data);
 
-    std::unordered_map<T, u64> get_frequency_map() const;
+    // 返回树内部表的引用，不复制；树销毁或重建后失效
+    const std::unordered_map<T, u64> &get_frequency_map() const;
 
-    std::unordered_map<T, std::pair<u64, u8>> get_code_map() const;
+    const std::unordered_map<T, std::pair<u64, u8>> &get_code_map() const;
 
     u8 get_frequency_length();
 
@@ -180,4 +181,66 @@ private:
 
 
 
+// 按表解码的后端（上下文、整像素、分块、多位符号等）建表时要求的最长码长
+inline constexpr u8 TABLE_CODE_BITS = 32;
+
+// 编码端限制码长：counts按符号下标给出频数，建出的树最长码长超过max_bits时，
+// 把出现过的符号的频数减半（至少保留1）后重新建树检查，直到满足为止，返回是否压平过。
+// 解码端按文件中保存的频数重建同一棵树，因此编码端要用压平后的counts建表并保存
+template <typename T>
+bool limit_code_length(std::vector<u64> &counts, u8 max_bits)
+{
+    // 最长码长为d的哈夫曼树总频数至少为斐波那契数F(d+2)，总数更小时不必建树检查
+    u64 total = 0;
+    for (u64 count : counts)
+    {
+        total += count;
+    }
+    u64 previous = 1, current = 1; // F(1), F(2)
+    for (u32 i = 2; i < static_cast<u32>(max_bits) + 3 && current <= total; i++)
+    {
+        u64 next = previous + current;
+        previous = current;
+        current = next;
+    }
+    if (total < current)
+    {
+        return false;
+    }
+
+    bool flattened = false;
+    while (true)
+    {
+        std::unordered_map<T, u64> frequency_map;
+        for (size_t s = 0; s < counts.size(); s++)
+        {
+            if (counts[s] > 0)
+            {
+                frequency_map[static_cast<T>(s)] = counts[s];
+            }
+        }
+        if (frequency_map.size() < 2)
+        {
+            return flattened;
+        }
+        HuffmanTree<T> tree;
+        tree.input_data(frequency_map);
+        tree.spawnTree();
+        u8 longest = 0;
+        for (const auto &code : tree.get_code_map())
+        {
+            longest = std::max(longest, code.second.second);
+        }
+        if (longest <= max_bits)
+        {
+            return flattened;
+        }
+        for (u64 &count : counts)
+        {
+            count = (count + 1) / 2;
+        }
+        flattened = true;
+    }
+}
+
 #endif
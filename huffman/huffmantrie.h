@@ -0,0 +1,174 @@
+#ifndef HUFFMANTRIE_H
+#define HUFFMANTRIE_H
+
+#include <vector>
+#include <stdexcept>
+#include <unordered_map>
+#include "huffmantree.h"
+#include "bitio.h"
+#include "../logger/Logger.h"
+
+// 宽字母表（u16/u32符号）的多位字典树解码
+// 把哈夫曼树展开成连续的32位表项数组：根表用ROOT_BITS位索引，之后每层用STRIDE_BITS位索引，
+// 各层子表按广度优先顺序依次排在数组中。每步查表消耗多位，热点的根表和第一层子表集中在数组开头，
+// 不再像node<T>指针树那样在堆上逐位跳转。
+// 表项：最高位为1表示叶子，[27,31)为该层消耗的位数，低27位为符号下标；
+//       最高位为0表示子表，[27,31)为子表的索引位数，低27位为子表在数组中的起点
+template <typename T>
+class HuffmanTrie
+{
+public:
+    static constexpr u32 ROOT_BITS = 10;
+    static constexpr u32 STRIDE_BITS = 4;
+
+    // 只在构造时读取树，之后不再依赖HuffmanTree的生命周期
+    explicit HuffmanTrie(node<T> *root)
+    {
+        if (root == nullptr)
+        {
+            throw std::runtime_error("Huffman tree root is null");
+        }
+        std::unordered_map<node<T> *, u32> heights;
+        measure(root, heights);
+        std::unordered_map<T, u32> symbol_index;
+
+        struct Pending
+        {
+            node<T> *subtree;
+            u32 base;
+            u32 bits;
+        };
+        root_bits = std::min(ROOT_BITS, heights[root]);
+        table.resize(1u << root_bits);
+        std::vector<Pending> queue(1, Pending{root, 0, root_bits});
+        for (size_t q = 0; q < queue.size(); q++)
+        {
+            Pending level = queue[q];
+            for (u32 v = 0; v < (1u << level.bits); v++)
+            {
+                node<T> *current = level.subtree;
+                u32 depth = 0;
+                while (current != nullptr && !current->is_leaf && depth < level.bits)
+                {
+                    u32 bit = (v >> (level.bits - 1 - depth)) & 1;
+                    current = bit ? current->right_child : current->left_child;
+                    depth++;
+                }
+                u32 entry;
+                if (current == nullptr)
+                {
+                    entry = LEAF | (level.bits << SHIFT) | INVALID_INDEX;
+                }
+                else if (current->is_leaf)
+                {
+                    entry = LEAF | (depth << SHIFT) | symbolIndex(current->data, symbol_index);
+                }
+                else
+                {
+                    // 每个内部节点只会从一个v到达，子表只分配一次
+                    u32 child_bits = std::min(STRIDE_BITS, heights[current]);
+                    u32 child_base = static_cast<u32>(table.size());
+                    if (child_base > INDEX_MASK - (1u << child_bits))
+                    {
+                        throw std::runtime_error("Huffman trie too large");
+                    }
+                    table.resize(table.size() + (1u << child_bits));
+                    queue.push_back(Pending{current, child_base, child_bits});
+                    entry = (child_bits << SHIFT) | child_base;
+                }
+                table[level.base + v] = entry;
+            }
+        }
+    }
+
+    inline T decode(BitReader &reader) const
+    {
+        u32 window = reader.peek(32);
+        u32 entry = table[root_bits == 0 ? 0 : window >> (32 - root_bits)];
+        u32 consumed = 0;
+        u32 bits = root_bits;
+        while (!(entry & LEAF))
+        {
+            consumed += bits;
+            bits = (entry >> SHIFT) & 0xF;
+            if (consumed + bits > 32)
+            {
+                invalid();
+            }
+            entry = table[(entry & INDEX_MASK) + ((window << consumed) >> (32 - bits))];
+        }
+        u32 index = entry & INDEX_MASK;
+        if (index == INVALID_INDEX)
+        {
+            invalid();
+        }
+        reader.skip(consumed + ((entry >> SHIFT) & 0xF));
+        return symbols[index];
+    }
+
+    // 展开后的表项数，便于评估内存占用
+    size_t size() const { return table.size(); }
+
+private:
+    static constexpr u32 LEAF = 0x80000000u;
+    static constexpr u32 SHIFT = 27;
+    static constexpr u32 INDEX_MASK = (1u << SHIFT) - 1;
+    static constexpr u32 INVALID_INDEX = INDEX_MASK;
+
+    std::vector<u32> table;
+    std::vector<T> symbols;
+    u32 root_bits;
+
+    // 后序遍历求每个内部节点的子树高度（叶子为0）
+    static void measure(node<T> *root, std::unordered_map<node<T> *, u32> &heights)
+    {
+        std::vector<std::pair<node<T> *, bool>> stack(1, std::make_pair(root, false));
+        while (!stack.empty())
+        {
+            std::pair<node<T> *, bool> top = stack.back();
+            stack.pop_back();
+            node<T> *current = top.first;
+            if (current == nullptr || current->is_leaf)
+            {
+                continue;
+            }
+            if (!top.second)
+            {
+                stack.push_back(std::make_pair(current, true));
+                stack.push_back(std::make_pair(current->left_child, false));
+                stack.push_back(std::make_pair(current->right_child, false));
+                continue;
+            }
+            u32 height = 0;
+            for (node<T> *child : {current->left_child, current->right_child})
+            {
+                if (child != nullptr && !child->is_leaf)
+                {
+                    height = std::max(height, heights[child]);
+                }
+            }
+            heights[current] = height + 1;
+        }
+    }
+
+    u32 symbolIndex(T symbol, std::unordered_map<T, u32> &symbol_index)
+    {
+        auto it = symbol_index.find(symbol);
+        if (it != symbol_index.end())
+        {
+            return it->second;
+        }
+        u32 index = static_cast<u32>(symbols.size());
+        symbols.push_back(symbol);
+        symbol_index[symbol] = index;
+        return index;
+    }
+
+    static void invalid()
+    {
+        Logger::getInstance().error("Invalid bit sequence");
+        throw std::runtime_error("Invalid bit sequence");
+    }
+};
+
+#endif // HUFFMANTRIE_H
@@ -0,0 +1,204 @@
+#ifndef HUFFMANVALIDATOR_H
+#define HUFFMANVALIDATOR_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "huffmantree.h"
+
+// 只计数不输出的哈夫曼位流校验
+// 内部节点不多时（字节字母表至多255个），预先为每个“当前节点 × 输入字节”算出走完8位后所在的节点
+// 和途中解出的符号数，校验时每字节查一次表；内部节点过多的宽字母表逐位走树。
+// 位流可以分段送入，只保存当前节点、计数和最后一个字节，内存与位流长度无关
+template <typename T>
+class HuffmanValidator
+{
+public:
+    static constexpr u32 MAX_TABLE_NODES = 1024;
+
+    // root由对应的HuffmanTree持有，需保证其生命周期长于本对象
+    explicit HuffmanValidator(node<T> *root) : root(root), state(0), count(0), pending(0), has_pending(false), invalid(false)
+    {
+        if (root == nullptr)
+        {
+            throw std::runtime_error("Huffman tree root is null");
+        }
+        if (root->is_leaf)
+        {
+            return;
+        }
+        std::vector<node<T> *> stack(1, root);
+        while (!stack.empty())
+        {
+            node<T> *current = stack.back();
+            stack.pop_back();
+            index[current] = static_cast<u32>(nodes.size());
+            nodes.push_back(current);
+            for (node<T> *child : {current->left_child, current->right_child})
+            {
+                if (child != nullptr && !child->is_leaf)
+                {
+                    stack.push_back(child);
+                }
+            }
+        }
+        if (nodes.size() > MAX_TABLE_NODES)
+        {
+            return;
+        }
+        table.resize(nodes.size() * 256);
+        for (u32 n = 0; n < nodes.size(); n++)
+        {
+            for (u32 byte = 0; byte < 256; byte++)
+            {
+                Entry &entry = table[n * 256 + byte];
+                node<T> *current = nodes[n];
+                for (int b = 7; b >= 0 && current != nullptr; b--)
+                {
+                    current = (byte >> b) & 1 ? current->right_child : current->left_child;
+                    if (current != nullptr && current->is_leaf)
+                    {
+                        entry.symbols++;
+                        current = root;
+                    }
+                }
+                entry.invalid = current == nullptr;
+                entry.next = current == nullptr ? 0 : index[current];
+            }
+        }
+    }
+
+    // 送入下一段位流；最后一个字节要等知道位流结束后再按剩余符号数逐位检查，先留着
+    void feed(const u8 *bytes, size_t size)
+    {
+        for (size_t i = 0; i < size && !invalid; i++)
+        {
+            if (has_pending)
+            {
+                step(pending);
+            }
+            pending = bytes[i];
+            has_pending = true;
+        }
+    }
+
+    // 位流结束：检查恰好解出code_num个符号、没有无效路径、末尾不足一字节的填充位全为0
+    bool finish(u64 code_num, std::string &error)
+    {
+        if (root->is_leaf)
+        {
+            // 只有一种符号时编码长度为0，位流应为空
+            if (has_pending)
+            {
+                error = "single-symbol stream is not empty";
+                return false;
+            }
+            count = code_num;
+            return true;
+        }
+        if (invalid)
+        {
+            error = "invalid code path";
+            return false;
+        }
+        if (!has_pending)
+        {
+            if (code_num != 0)
+            {
+                error = "bitset is empty";
+                return false;
+            }
+            return true;
+        }
+        if (count >= code_num)
+        {
+            error = "bitset longer than symbol count";
+            return false;
+        }
+        node<T> *current = nodes[state];
+        for (int b = 7; b >= 0; b--)
+        {
+            if (count == code_num)
+            {
+                if ((pending & ((1u << (b + 1)) - 1)) != 0)
+                {
+                    error = "padding bits are not zero";
+                    return false;
+                }
+                return true;
+            }
+            current = (pending >> b) & 1 ? current->right_child : current->left_child;
+            if (current == nullptr)
+            {
+                error = "invalid code path";
+                return false;
+            }
+            if (current->is_leaf)
+            {
+                count++;
+                current = root;
+            }
+        }
+        if (count != code_num)
+        {
+            error = "bitset shorter than symbol count";
+            return false;
+        }
+        return true;
+    }
+
+    // 目前已完整解出的符号数
+    u64 symbols() const { return count; }
+
+private:
+    struct Entry
+    {
+        u32 next = 0;
+        u8 symbols = 0;
+        bool invalid = false;
+    };
+
+    node<T> *root;
+    std::vector<node<T> *> nodes; // 内部节点，0为根
+    std::unordered_map<node<T> *, u32> index;
+    std::vector<Entry> table;
+    u32 state;
+    u64 count;
+    u8 pending;
+    bool has_pending;
+    bool invalid;
+
+    inline void step(u8 byte)
+    {
+        if (root->is_leaf)
+        {
+            return;
+        }
+        if (!table.empty())
+        {
+            const Entry &entry = table[state * 256 + byte];
+            count += entry.symbols;
+            state = entry.next;
+            invalid = entry.invalid;
+            return;
+        }
+        node<T> *current = nodes[state];
+        for (int b = 7; b >= 0; b--)
+        {
+            current = (byte >> b) & 1 ? current->right_child : current->left_child;
+            if (current == nullptr)
+            {
+                invalid = true;
+                return;
+            }
+            if (current->is_leaf)
+            {
+                count++;
+                current = root;
+            }
+        }
+        state = index[current];
+    }
+};
+
+#endif // HUFFMANVALIDATOR_H
@@ -0,0 +1,245 @@
+#include "pixelhuffman.h"
+#include "bitio.h"
+#include "bmplayout.h"
+#include "../logger/Logger.h"
+#include <algorithm>
+
+void PixelHuffman::PixelIndex::build(const std::vector<u32> &palette){
+    u32 bits = 1;
+    while((1u << bits) < palette.size() * 2){
+        bits++;
+    }
+    mask = (1u << bits) - 1;
+    shift = 32 - bits;
+    slots.assign(static_cast<size_t>(mask) + 1, Slot{0, 0});
+    for(u32 j = 0; j < palette.size(); j++){
+        u32 slot = hash(palette[j]);
+        while(slots[slot].symbol != 0){
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = Slot{palette[j], j + 1};
+    }
+}
+
+template <typename L, typename P>
+void PixelHuffman::walk(const u8 *data, u64 size, L &&literal, P &&pixel){
+    u64 i = 0;
+    u64 header_end = size < BmpLayout::HEADER_BYTES ? size : BmpLayout::HEADER_BYTES;
+    for(; i < header_end; i++){
+        literal(i);
+    }
+    if(i == size){
+        return;
+    }
+
+    BmpLayout layout = BmpLayout::parse(data, size);
+    for(; i < layout.offset && i < size; i++){
+        literal(i);
+    }
+
+    if(layout.valid() && (layout.bit_count == 24 || layout.bit_count == 32)){
+        const u32 pb = layout.pixel_bytes;
+        const u64 pixels_per_row = static_cast<u64>(layout.width);
+        const u64 padding = layout.row_bytes - pixels_per_row * pb;
+        u64 rows = static_cast<u64>(layout.height < 0 ? -static_cast<long long>(layout.height) : layout.height);
+        for(u64 r = 0; r < rows && i + layout.row_bytes <= size; r++){
+            for(u64 x = 0; x < pixels_per_row; x++, i += pb){
+                pixel(i, pb);
+            }
+            for(u64 p = 0; p < padding; p++, i++){
+                literal(i);
+            }
+        }
+    }
+
+    // 像素数组之后的剩余字节
+    for(; i < size; i++){
+        literal(i);
+    }
+}
+
+bool PixelHuffman::supports(const u8 *data, u64 size){
+    BmpLayout layout = BmpLayout::parse(data, size);
+    return layout.valid() && (layout.bit_count == 24 || layout.bit_count == 32);
+}
+
+PixelHuffman::PixelHuffman(const u8 *data, u64 size){
+    const u8 *src = data;
+
+    // 第一遍：Misra-Gries近似统计高频像素，计数器满时全部减一
+    std::unordered_map<u32, u64> counters;
+    counters.reserve(HEAVY_HITTER_CAPACITY * 2);
+    u32 pixel_bytes = 3;
+    walk(src, size, [](u64){}, [&](u64 i, u32 pb){
+        pixel_bytes = pb;
+        u32 value = loadPixel(src + i, pb);
+        auto it = counters.find(value);
+        if(it != counters.end()){
+            it->second++;
+        }else if(counters.size() < HEAVY_HITTER_CAPACITY){
+            counters.emplace(value, 1);
+        }else{
+            for(auto c = counters.begin(); c != counters.end();){
+                if(--c->second == 0){
+                    c = counters.erase(c);
+                }else{
+                    ++c;
+                }
+            }
+        }
+    });
+    wide_keys = pixel_bytes > 3;
+
+    std::vector<std::pair<u64, u32>> candidates;
+    for(const auto &c : counters){
+        if(c.second >= MIN_PIXEL_COUNT){
+            candidates.emplace_back(c.second, c.first);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const std::pair<u64, u32> &a, const std::pair<u64, u32> &b){
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    if(candidates.size() > MAX_PALETTE){
+        candidates.resize(MAX_PALETTE);
+    }
+    for(const auto &c : candidates){
+        palette.push_back(c.second);
+    }
+    std::sort(palette.begin(), palette.end());
+    index.build(palette);
+    Logger::getInstance().debug("整像素调色板大小: " + std::to_string(palette.size()));
+
+    // 第二遍：按调色板精确统计符号频数
+    std::vector<u64> counts(LITERALS + palette.size(), 0);
+    walk(src, size, [&](u64 i){
+        counts[src[i]]++;
+    }, [&](u64 i, u32 pb){
+        int symbol = index.find(loadPixel(src + i, pb));
+        if(symbol >= 0){
+            counts[LITERALS + symbol]++;
+        }else{
+            for(u32 b = 0; b < pb; b++){
+                counts[src[i + b]]++;
+            }
+        }
+    });
+    // 频数悬殊时码长可能超过查表解码的上限，压平后再建表
+    if(limit_code_length<u16>(counts, TABLE_CODE_BITS)){
+        Logger::getInstance().debug("整像素码表码长超过 " + std::to_string(TABLE_CODE_BITS) + " 位，已压平频数");
+    }
+    build(counts);
+}
+
+PixelHuffman::PixelHuffman(const std::unordered_map<u64, u64> &frequency_map){
+    std::vector<u64> literal_counts(LITERALS, 0);
+    std::vector<std::pair<u32, u64>> entries;
+    for(const auto &entry : frequency_map){
+        if(entry.first < LITERALS){
+            literal_counts[entry.first] = entry.second;
+            continue;
+        }
+        u64 value = entry.first - LITERALS;
+        if(value > 0xFFFFFFFFull || entries.size() >= MAX_PALETTE){
+            Logger::getInstance().error("Invalid pixel palette entry");
+            throw std::runtime_error("Invalid pixel palette entry");
+        }
+        entries.emplace_back(static_cast<u32>(value), entry.second);
+    }
+    std::sort(entries.begin(), entries.end());
+
+    std::vector<u64> counts(literal_counts);
+    for(const auto &entry : entries){
+        palette.push_back(entry.first);
+        counts.push_back(entry.second);
+    }
+    build(counts);
+}
+
+void PixelHuffman::build(const std::vector<u64> &counts){
+    std::unordered_map<u16, u64> frequency_map;
+    for(size_t s = 0; s < counts.size(); s++){
+        if(counts[s] > 0){
+            frequency_map[static_cast<u16>(s)] = counts[s];
+        }
+    }
+    if(frequency_map.empty()){
+        Logger::getInstance().error("Empty frequency map");
+        throw std::runtime_error("Empty frequency map");
+    }
+    tree.reset(new HuffmanTree<u16>());
+    tree->input_data(frequency_map);
+    tree->spawnTree();
+
+    codes.assign(counts.size(), std::make_pair(0, 0));
+    for(auto &code : tree->get_code_map()){
+        if(code.second.second > TABLE_CODE_BITS){
+            Logger::getInstance().error("Huffman code longer than 32 bits");
+            throw std::runtime_error("Huffman code longer than 32 bits");
+        }
+        codes[code.first] = code.second;
+    }
+    lookup.reset(new HuffmanTrie<u16>(tree->get_root()));
+}
+
+std::vector<u8> PixelHuffman::encode(const u8 *data, u64 size) const {
+    const u8 *src = data;
+    BitWriter writer;
+    writer.reserve(encode_reserve(size));
+    auto put = [&](u32 symbol){
+        const std::pair<u64, u8> &code = codes[symbol];
+        writer.put(code.first, code.second);
+    };
+    walk(src, size, [&](u64 i){
+        put(src[i]);
+    }, [&](u64 i, u32 pb){
+        int symbol = index.find(loadPixel(src + i, pb));
+        if(symbol >= 0){
+            put(LITERALS + symbol);
+        }else{
+            for(u32 b = 0; b < pb; b++){
+                put(src[i + b]);
+            }
+        }
+    });
+    return writer.finish();
+}
+
+void PixelHuffman::decodeInto(const u8 *bytes, u64 size, u8 *out, u64 byte_num) const {
+    BitReader reader(bytes, size);
+    auto literal = [&](u64 i){
+        u16 symbol = lookup->decode(reader);
+        if(symbol >= LITERALS){
+            Logger::getInstance().error("Invalid bit sequence");
+            throw std::runtime_error("Invalid bit sequence");
+        }
+        out[i] = static_cast<u8>(symbol);
+    };
+    walk(out, byte_num, literal, [&](u64 i, u32 pb){
+        u16 symbol = lookup->decode(reader);
+        if(symbol >= LITERALS){
+            u32 value = palette[symbol - LITERALS];
+            for(u32 b = 0; b < pb; b++){
+                out[i + b] = static_cast<u8>(value >> (8 * b));
+            }
+            return;
+        }
+        // 逃逸：第一个字面量已读出，再读其余通道
+        out[i] = static_cast<u8>(symbol);
+        for(u32 b = 1; b < pb; b++){
+            literal(i + b);
+        }
+    });
+    if(reader.overrun() || (reader.bitSize() - reader.tell()) >= 8){
+        Logger::getInstance().error("Decoded count not equal to code number");
+        throw std::runtime_error("Decoded count not equal to code number");
+    }
+}
+
+std::unordered_map<u64, u64> PixelHuffman::get_frequency_map() const {
+    std::unordered_map<u64, u64> frequency_map;
+    for(auto &entry : tree->get_frequency_map()){
+        u64 key = entry.first < LITERALS ? entry.first : LITERALS + static_cast<u64>(palette[entry.first - LITERALS]);
+        frequency_map[key] = entry.second;
+    }
+    return frequency_map;
+}
@@ -0,0 +1,118 @@
+#ifndef PIXELHUFFMAN_H
+#define PIXELHUFFMAN_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "huffmantree.h"
+#include "huffmantrie.h"
+
+// 整像素哈夫曼编码（24/32位图像）
+// 出现最多的K种像素各占一个符号，其余字节（文件头、行填充、不在表中的像素）
+// 按字节作为字面量符号编码。像素位置上读到字面量即视为逃逸，随后再读pixel_bytes-1个字面量。
+// 符号表：0..255为字面量，256+j为第j个调色板像素（调色板按像素值升序）
+class PixelHuffman
+{
+public:
+    static constexpr u32 LITERALS = 256;
+
+    // 调色板最大容量
+    static constexpr u32 MAX_PALETTE = 4096;
+
+    // 近似高频统计（Misra-Gries）保留的计数器数量
+    static constexpr u32 HEAVY_HITTER_CAPACITY = MAX_PALETTE * 2;
+
+    // 进入调色板的最小出现次数，低于此值时码表开销大于收益
+    static constexpr u64 MIN_PIXEL_COUNT = 8;
+
+    // 仅支持24/32位图像
+    static bool supports(const u8 *data, u64 size);
+    static bool supports(const std::vector<u8> &data) { return supports(data.data(), data.size()); }
+
+    // 编码端：近似统计高频像素确定调色板，再精确统计符号频数并建树
+    PixelHuffman(const u8 *data, u64 size);
+    explicit PixelHuffman(const std::vector<u8> &data) : PixelHuffman(data.data(), data.size()) {}
+
+    // 解码端：键小于256为字面量，否则为 256 + 像素值
+    explicit PixelHuffman(const std::unordered_map<u64, u64> &frequency_map);
+
+    std::vector<u8> encode(const u8 *data, u64 size) const;
+    std::vector<u8> encode(const std::vector<u8> &data) const { return encode(data.data(), data.size()); }
+
+    // 解码byte_num字节写入out，像素排布取自out中已解出的文件头
+    void decodeInto(const u8 *bytes, u64 size, u8 *out, u64 byte_num) const;
+    std::vector<u8> decode(const std::vector<u8> &bytes, u64 byte_num) const {
+        std::vector<u8> result(byte_num);
+        decodeInto(bytes.data(), bytes.size(), result.data(), byte_num);
+        return result;
+    }
+
+    std::unordered_map<u64, u64> get_frequency_map() const;
+
+    u8 get_frequency_length() { return tree->get_frequency_length(); }
+
+    // 32位像素值加256会超出u32
+    u8 get_key_size() const { return wide_keys ? 8 : 4; }
+
+    u32 get_palette_size() const { return static_cast<u32>(palette.size()); }
+
+private:
+    // 像素值 -> 调色板下标的开放寻址表，容量为2的幂且至少为调色板的两倍
+    class PixelIndex
+    {
+    public:
+        void build(const std::vector<u32> &palette);
+
+        // 未找到时返回-1
+        inline int find(u32 value) const
+        {
+            u32 slot = hash(value);
+            while (slots[slot].symbol != 0)
+            {
+                if (slots[slot].value == value)
+                {
+                    return static_cast<int>(slots[slot].symbol - 1);
+                }
+                slot = (slot + 1) & mask;
+            }
+            return -1;
+        }
+
+    private:
+        struct Slot
+        {
+            u32 value;
+            u32 symbol; // 下标+1，0表示空
+        };
+        std::vector<Slot> slots;
+        u32 mask = 0;
+        u32 shift = 32;
+
+        inline u32 hash(u32 value) const { return (value * 2654435761u) >> shift & mask; }
+    };
+
+    std::vector<u32> palette;     // 升序
+    PixelIndex index;
+    bool wide_keys = false;
+    std::unique_ptr<HuffmanTree<u16>> tree;
+    std::unique_ptr<HuffmanTrie<u16>> lookup;
+    std::vector<std::pair<u64, u8>> codes;
+
+    void build(const std::vector<u64> &counts);
+
+    // 按顺序遍历文件：literal(i)处理单个字节，pixel(i)处理从i开始的一个完整像素
+    template <typename L, typename P>
+    static void walk(const u8 *data, u64 size, L &&literal, P &&pixel);
+
+    static inline u32 loadPixel(const u8 *p, u32 pixel_bytes)
+    {
+        u32 value = 0;
+        for (u32 b = 0; b < pixel_bytes; b++)
+        {
+            value |= static_cast<u32>(p[b]) << (8 * b);
+        }
+        return value;
+    }
+};
+
+#endif // PIXELHUFFMAN_H
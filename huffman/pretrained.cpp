@@ -0,0 +1,196 @@
+#include "pretrained.h"
+#include "pretraineddefaults.h"
+#include "bitio.h"
+#include "../FileStream/FileReader.h"
+#include "../FileStream/FileWriter.h"
+#include "../logger/Logger.h"
+#include <cmath>
+#include <mutex>
+
+std::vector<u16> PretrainedTables::train(const std::vector<std::vector<u8>> &samples){
+    std::vector<u64> counts(256, 0);
+    for(const auto &sample : samples){
+        for(u8 byte : sample){
+            counts[byte]++;
+        }
+    }
+    u64 max_count = 1;
+    for(u64 count : counts){
+        max_count = count > max_count ? count : max_count;
+    }
+    // 样本中没出现的符号也要有编码，缩放后至少为1
+    std::vector<u16> result(256);
+    for(u32 s = 0; s < 256; s++){
+        u64 scaled = (counts[s] * 65535 + max_count / 2) / max_count;
+        result[s] = static_cast<u16>(scaled > 0 ? scaled : 1);
+    }
+    return result;
+}
+
+std::map<u8, std::vector<u16>> PretrainedTables::loadDictionary(const std::string &filename){
+    Logger::getInstance().info("加载码表字典: " + filename);
+    FileReader reader(filename);
+    if(reader.readu16() != DICTIONARY_MAGIC){
+        Logger::getInstance().error("码表字典格式错误: " + filename);
+        throw std::runtime_error("Invalid dictionary file");
+    }
+    u8 version = reader.readu8();
+    if(version != DICTIONARY_VERSION){
+        Logger::getInstance().error("不支持的码表字典版本: " + std::to_string(version));
+        throw std::runtime_error("Unsupported dictionary version");
+    }
+    u8 count = reader.readu8();
+    std::map<u8, std::vector<u16>> tables;
+    for(u8 t = 0; t < count; t++){
+        u8 id = reader.readu8();
+        std::vector<u16> table(256);
+        reader.readArray(table.data(), table.size());
+        for(u32 s = 0; s < 256; s++){
+            if(table[s] == 0){
+                Logger::getInstance().error("码表字典中存在频数为0的符号");
+                throw std::runtime_error("Invalid dictionary table");
+            }
+        }
+        tables[id] = table;
+    }
+    return tables;
+}
+
+bool PretrainedTables::saveDictionary(const std::string &filename, const std::map<u8, std::vector<u16>> &tables){
+    Logger::getInstance().info("保存码表字典: " + filename);
+    FileWriter writer(filename);
+    writer.writeu16(DICTIONARY_MAGIC);
+    writer.writeu8(DICTIONARY_VERSION);
+    writer.writeu8(static_cast<u8>(tables.size()));
+    for(const auto &table : tables){
+        writer.writeu8(table.first);
+        writer.writeArray(table.second.data(), 256);
+    }
+    return writer.close();
+}
+
+std::vector<u16> PretrainedTables::frequencies(u8 id, const std::string &dictionary){
+    if(id < BUILTIN_COUNT){
+        return std::vector<u16>(PRETRAINED_DEFAULTS[id], PRETRAINED_DEFAULTS[id] + 256);
+    }
+    if(id < FIRST_DICTIONARY_ID || dictionary.empty()){
+        Logger::getInstance().error("码表编号 " + std::to_string(id) + " 需要码表字典");
+        throw std::runtime_error("Pretrained table not found");
+    }
+    std::shared_ptr<const std::map<u8, std::vector<u16>>> tables = dictionaryTables(dictionary);
+    auto it = tables->find(id);
+    if(it == tables->end()){
+        Logger::getInstance().error("码表字典中没有编号 " + std::to_string(id));
+        throw std::runtime_error("Pretrained table not found");
+    }
+    return it->second;
+}
+
+std::shared_ptr<const std::map<u8, std::vector<u16>>> PretrainedTables::dictionaryTables(const std::string &dictionary){
+    static std::mutex cache_mutex;
+    static std::map<std::string, std::shared_ptr<const std::map<u8, std::vector<u16>>>> cache;
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto it = cache.find(dictionary);
+    if(it != cache.end()){
+        return it->second;
+    }
+    std::shared_ptr<const std::map<u8, std::vector<u16>>> tables =
+        std::make_shared<const std::map<u8, std::vector<u16>>>(loadDictionary(dictionary));
+    cache[dictionary] = tables;
+    return tables;
+}
+
+std::shared_ptr<const PretrainedTables::Table> PretrainedTables::get(u8 id, const std::string &dictionary){
+    static std::mutex cache_mutex;
+    static std::map<std::pair<std::string, u8>, std::shared_ptr<const Table>> cache;
+
+    std::pair<std::string, u8> key(id < BUILTIN_COUNT ? std::string() : dictionary, id);
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto it = cache.find(key);
+    if(it != cache.end()){
+        return it->second;
+    }
+
+    std::vector<u16> counts = frequencies(id, dictionary);
+    std::unordered_map<u8, u64> frequency_map;
+    for(u32 s = 0; s < 256; s++){
+        frequency_map[static_cast<u8>(s)] = counts[s];
+    }
+    std::shared_ptr<Table> table = std::make_shared<Table>();
+    table->tree.reset(new HuffmanTree<u8>());
+    table->tree->input_data(frequency_map);
+    table->tree->spawnTree();
+    table->codes.assign(256, std::make_pair(0, 0));
+    for(auto &code : table->tree->get_code_map()){
+        if(code.second.second > TABLE_CODE_BITS){
+            Logger::getInstance().error("Huffman code longer than 32 bits");
+            throw std::runtime_error("Huffman code longer than 32 bits");
+        }
+        table->codes[code.first] = code.second;
+    }
+    table->lookup.reset(new HuffmanLookup<u8>(table->tree->get_root()));
+    cache[key] = table;
+    return table;
+}
+
+u8 PretrainedTables::choose(const u8 *data, u64 size, const std::string &dictionary){
+    std::vector<u64> histogram(256, 0);
+    for(u64 i = 0; i < size; i++){
+        histogram[data[i]]++;
+    }
+
+    std::map<u8, std::vector<u16>> candidates;
+    for(u8 id = 0; id < BUILTIN_COUNT; id++){
+        candidates[id] = frequencies(id, dictionary);
+    }
+    if(!dictionary.empty()){
+        for(auto &table : *dictionaryTables(dictionary)){
+            candidates[table.first] = table.second;
+        }
+    }
+
+    u8 best = 0;
+    double best_bits = 0;
+    for(const auto &candidate : candidates){
+        double total = 0;
+        for(u16 count : candidate.second){
+            total += count;
+        }
+        double bits = 0;
+        for(u32 s = 0; s < 256; s++){
+            if(histogram[s] > 0){
+                bits += histogram[s] * std::log2(total / candidate.second[s]);
+            }
+        }
+        if(candidate.first == candidates.begin()->first || bits < best_bits){
+            best_bits = bits;
+            best = candidate.first;
+        }
+    }
+    Logger::getInstance().debug("选择预训练码表 " + std::to_string(best) + "，估算 " + std::to_string(static_cast<u64>(best_bits / 8)) + " 字节");
+    return best;
+}
+
+std::vector<u8> PretrainedTables::encode(const Table &table, const u8 *data, u64 size){
+    // 码表与数据不匹配时输出可能比输入还大，按最长码长预留，只分配一次且不必先扫一遍数据；
+    // 预留而没有写到的页不会实际占用物理内存
+    BitWriter writer;
+    writer.reserve(static_cast<size_t>(size * table.lookup->max_length() / 8 + 1));
+    for(u64 i = 0; i < size; i++){
+        const std::pair<u64, u8> &code = table.codes[data[i]];
+        writer.put(code.first, code.second);
+    }
+    return writer.finish();
+}
+
+void PretrainedTables::decodeInto(const Table &table, const u8 *bytes, u64 size, u8 *out, u64 code_num){
+    BitReader reader(bytes, size);
+    for(u64 i = 0; i < code_num; i++){
+        out[i] = table.lookup->decode(reader);
+    }
+    if(reader.overrun() || (reader.bitSize() - reader.tell()) >= 8){
+        Logger::getInstance().error("Decoded count not equal to code number");
+        throw std::runtime_error("Decoded count not equal to code number");
+    }
+}
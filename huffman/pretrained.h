@@ -0,0 +1,65 @@
+#ifndef PRETRAINED_H
+#define PRETRAINED_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "huffmantree.h"
+#include "huffmanlookup.h"
+
+// 预训练的静态哈夫曼码表
+// 0..BUILTIN_COUNT-1为编译期内置表（pretraineddefaults.h），
+// FIRST_DICTIONARY_ID及以上的编号来自训练工具生成的字典文件。
+// 码表覆盖全部256个符号，文件中只记录编号，不保存频数表；
+// 同一张表在进程内只建一次树，之后的编码不需要统计频数也不需要建树
+class PretrainedTables
+{
+public:
+    static constexpr u8 BUILTIN_COUNT = 2;
+    static constexpr u8 FIRST_DICTIONARY_ID = 16;
+    static constexpr u8 AUTO_ID = 0xFF; // 按估算大小自动选择
+
+    // 字典文件：magic(u16 'HD') + 版本(u8) + 表数(u8)，每张表为 编号(u8) + 256个频数(u16)
+    static constexpr u16 DICTIONARY_MAGIC = 0x4448;
+    static constexpr u8 DICTIONARY_VERSION = 1;
+
+    struct Table
+    {
+        std::unique_ptr<HuffmanTree<u8>> tree;
+        std::unique_ptr<HuffmanLookup<u8>> lookup;
+        std::vector<std::pair<u64, u8>> codes; // 符号 -> (编码, 编码长度)
+    };
+
+    // 从样本累计频数，缩放到u16并保证每个符号至少为1
+    static std::vector<u16> train(const std::vector<std::vector<u8>> &samples);
+
+    static std::map<u8, std::vector<u16>> loadDictionary(const std::string &filename);
+
+    static bool saveDictionary(const std::string &filename, const std::map<u8, std::vector<u16>> &tables);
+
+    // 取编号对应的码表（带缓存），dictionary为空时只能使用内置表
+    static std::shared_ptr<const Table> get(u8 id, const std::string &dictionary);
+
+    // 按交叉熵选择编码data最短的表，需要一遍直方图统计但不建树
+    static u8 choose(const u8 *data, u64 size, const std::string &dictionary);
+    static u8 choose(const std::vector<u8> &data, const std::string &dictionary) { return choose(data.data(), data.size(), dictionary); }
+
+    static std::vector<u8> encode(const Table &table, const u8 *data, u64 size);
+    static std::vector<u8> encode(const Table &table, const std::vector<u8> &data) { return encode(table, data.data(), data.size()); }
+
+    static void decodeInto(const Table &table, const u8 *bytes, u64 size, u8 *out, u64 code_num);
+    static std::vector<u8> decode(const Table &table, const std::vector<u8> &bytes, u64 code_num) {
+        std::vector<u8> result(code_num);
+        decodeInto(table, bytes.data(), bytes.size(), result.data(), code_num);
+        return result;
+    }
+
+private:
+    static std::vector<u16> frequencies(u8 id, const std::string &dictionary);
+
+    // 解析后的字典（带缓存），同一字典文件在进程内只读取一次
+    static std::shared_ptr<const std::map<u8, std::vector<u16>>> dictionaryTables(const std::string &dictionary);
+};
+
+#endif // PRETRAINED_H
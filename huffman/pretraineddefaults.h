@@ -0,0 +1,50 @@
+#ifndef PRETRAINEDDEFAULTS_H
+#define PRETRAINEDDEFAULTS_H
+
+typedef unsigned short u16;
+
+// 内置预训练频数表（已缩放到u16，每个符号至少为1），编号即数组下标
+// 由 test/train_tables.cpp 的header模式生成，样本为合成的照片类和图表类测试图；
+// 固定来源的图像应使用该工具的dict模式按实际语料训练字典文件
+constexpr u16 PRETRAINED_DEFAULTS[2][256] = {
+    // 自然图像（照片、扫描件）：photo24、seq0、big24、g8
+    {
+        1262, 3655, 3775, 379, 1712, 2368, 378, 3823, 2716, 376, 2239, 2365, 374, 2843, 2889, 372,
+        3348, 3319, 371, 1969, 1863, 370, 3948, 3200, 367, 1697, 1862, 364, 65535, 28434, 21046, 18793,
+        15142, 14783, 13746, 16259, 11282, 13228, 10936, 9617, 10681, 11673, 8649, 12242, 9961, 8646, 10687, 10651,
+        6846, 8653, 9398, 8195, 10263, 8525, 6964, 10373, 7565, 5030, 10348, 9543, 4778, 10687, 8533, 4370,
+        9284, 8647, 4271, 10769, 7100, 5471, 10362, 6478, 7620, 7714, 7012, 7164, 7348, 9662, 4220, 10196,
+        7725, 4693, 9386, 6343, 38320, 6861, 9019, 17011, 10396, 7866, 16042, 9418, 6435, 15404, 7199, 9837,
+        10789, 10255, 6057, 14928, 8240, 9637, 10143, 10854, 6424, 13727, 7919, 9255, 10173, 10233, 7690, 11394,
+        9287, 9155, 10968, 10304, 8422, 11112, 10635, 8885, 11307, 10772, 8767, 10826, 11039, 9326, 11040, 11393,
+        9074, 11483, 11371, 9456, 11213, 11377, 8831, 11192, 11494, 9421, 10919, 11634, 8955, 10663, 12170, 9023,
+        10916, 12705, 10061, 9647, 14513, 8857, 12090, 10987, 10265, 9811, 15647, 8038, 12349, 12026, 10754, 7878,
+        17507, 7892, 12619, 16217, 10047, 10830, 19543, 10486, 9297, 39596, 8371, 11519, 5645, 10530, 9960, 7357,
+        10461, 8770, 8639, 7540, 10488, 6272, 9496, 12252, 5262, 9675, 9764, 6227, 11621, 7432, 7280, 9934,
+        8689, 7548, 10747, 8861, 7579, 10102, 7328, 6931, 11640, 11402, 6440, 8973, 11290, 8352, 9872, 9895,
+        7989, 10343, 12064, 9055, 12276, 11167, 9004, 11111, 13321, 9891, 13196, 13564, 13513, 12570, 17498, 13590,
+        20093, 24153, 25338, 63496, 2538, 352, 3775, 3286, 272, 2139, 2134, 225, 2665, 3058, 216, 2091,
+        2782, 213, 2665, 2258, 209, 3200, 3052, 203, 1784, 2035, 204, 2933, 3496, 196, 2100, 23024
+    },
+    // 合成图像（图表、界面截图、调色板图）：chart24、p32、c16、c4、c1、mixed
+    {
+        2870, 358, 376, 573, 377, 378, 571, 251, 38, 16, 16, 16, 14, 14, 15, 16,
+        210, 16, 213, 18, 19, 21, 22, 27, 28, 224, 31, 31, 33, 33, 9483, 36,
+        41, 40, 40, 43, 47, 50, 48, 52, 8131, 57, 60, 258, 62, 65, 70, 68,
+        72, 74, 81, 80, 83, 283, 92, 97, 100, 106, 113, 111, 4452, 120, 318, 319,
+        137, 139, 143, 149, 151, 161, 162, 370, 183, 183, 193, 192, 209, 208, 220, 232,
+        241, 250, 252, 257, 266, 472, 278, 286, 298, 292, 295, 306, 305, 314, 330, 326,
+        323, 329, 334, 338, 344, 348, 364, 361, 366, 362, 370, 369, 372, 386, 385, 402,
+        396, 399, 400, 395, 406, 409, 401, 592, 389, 401, 394, 413, 417, 412, 415, 413,
+        412, 607, 416, 413, 414, 412, 600, 401, 407, 600, 798, 401, 395, 396, 385, 383,
+        380, 362, 356, 366, 543, 338, 333, 321, 316, 310, 303, 500, 298, 289, 286, 279,
+        261, 262, 257, 251, 235, 229, 222, 214, 213, 203, 574, 184, 186, 179, 175, 164,
+        160, 353, 154, 147, 139, 142, 333, 133, 133, 126, 313, 117, 109, 107, 104, 94,
+        94, 89, 279, 82, 279, 80, 69, 265, 11593, 64, 59, 55, 245, 50, 242, 43,
+        39, 36, 36, 35, 34, 30, 30, 27, 25, 23, 219, 21, 21, 19, 18, 212,
+        17, 16, 17, 17, 17, 210, 14, 211, 211, 211, 17, 210, 16, 16, 17, 18,
+        1804, 17, 18, 17, 16, 15, 16, 16, 14, 15, 13020, 16, 17, 15, 211, 65535
+    },
+};
+
+#endif // PRETRAINEDDEFAULTS_H
@@ -0,0 +1,145 @@
+#include "ricecoder.h"
+#include "bitio.h"
+#include "bmplayout.h"
+#include "../logger/Logger.h"
+
+static inline u32 leading_zeros(u32 x){
+#if defined(__GNUC__) || defined(__clang__)
+    return x ? static_cast<u32>(__builtin_clz(x)) : 32;
+#else
+    u32 n = 0;
+    while(n < 32 && !(x & 0x80000000u)){
+        x <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+// 残差折叠到0..255：0,-1,1,-2,2...
+static inline u32 fold(u8 value, u8 pred){
+    int e = static_cast<signed char>(static_cast<u8>(value - pred));
+    return e >= 0 ? static_cast<u32>(e) << 1 : (static_cast<u32>(-e) << 1) - 1;
+}
+
+static inline u8 unfold(u32 m, u8 pred){
+    int e = (m & 1) ? -static_cast<int>((m + 1) >> 1) : static_cast<int>(m >> 1);
+    return static_cast<u8>(pred + e);
+}
+
+// LOCO-I的中值边缘检测预测器
+static inline u8 med(u8 a, u8 b, u8 c){
+    u8 mx = a > b ? a : b;
+    u8 mn = a > b ? b : a;
+    if(c >= mx) return mn;
+    if(c <= mn) return mx;
+    return static_cast<u8>(a + b - c);
+}
+
+template <typename Coder>
+void RiceCoder::run(const u8 *data, u64 size, Coder &&coder) const {
+    std::vector<Context> contexts(CONTEXT_COUNT, Context{4, 1});
+    const u32 header_context = CONTEXT_COUNT - 1;
+
+    auto step = [&](u64 i, u8 pred, u32 context_index){
+        Context &ctx = contexts[context_index];
+        u32 k = 0;
+        while((ctx.n << k) < ctx.a && k < 7){
+            k++;
+        }
+        coder(i, pred, k);
+        ctx.a += fold(data[i], pred);
+        ctx.n++;
+        if(ctx.n >= RESET_THRESHOLD){
+            ctx.a >>= 1;
+            ctx.n >>= 1;
+        }
+    };
+
+    // 文件头：用前一个字节预测
+    u64 i = 0;
+    u64 header_end = size < BmpLayout::HEADER_BYTES ? size : BmpLayout::HEADER_BYTES;
+    for(; i < header_end; i++){
+        step(i, i > 0 ? data[i - 1] : 0, header_context);
+    }
+    if(i == size){
+        return;
+    }
+
+    // 从已经处理过的头部解析像素排布
+    BmpLayout layout = BmpLayout::parse(data, size);
+
+    // 调色板等剩余头部
+    for(; i < layout.offset && i < size; i++){
+        step(i, data[i - 1], header_context);
+    }
+
+    // 像素数据：MED预测，上下文 = 通道 × 量化梯度
+    const u32 pb = layout.pixel_bytes;
+    const u64 rb = layout.row_bytes;
+    u64 col = 0, row = 0;
+    u32 channel = 0;
+    for(; i < size; i++){
+        u8 a = col >= pb ? data[i - pb] : (row > 0 ? data[i - rb] : 0);
+        u8 b = row > 0 ? data[i - rb] : a;
+        u8 c = (row > 0 && col >= pb) ? data[i - rb - pb] : b;
+        u32 activity = static_cast<u32>(a > c ? a - c : c - a) + static_cast<u32>(b > c ? b - c : c - b) + 1;
+        u32 level = 31 - leading_zeros(activity);
+        if(level >= ACTIVITY_LEVELS){
+            level = ACTIVITY_LEVELS - 1;
+        }
+        u32 ch = channel < MAX_CHANNELS ? channel : MAX_CHANNELS - 1;
+        step(i, med(a, b, c), ch * ACTIVITY_LEVELS + level);
+
+        if(++channel == pb){
+            channel = 0;
+        }
+        if(rb != 0 && ++col == rb){
+            col = 0;
+            channel = 0;
+            row++;
+        }else if(rb == 0){
+            col++;
+        }
+    }
+}
+
+std::vector<u8> RiceCoder::encode(const u8 *data, u64 size) const {
+    BitWriter writer;
+    writer.reserve(encode_reserve(size));
+    run(data, size, [&](u64 i, u8 pred, u32 k){
+        u32 m = fold(data[i], pred);
+        u32 q = m >> k;
+        if(q < ESCAPE_LIMIT){
+            // q个0、一个1，再接k位低位
+            writer.put((1u << k) | (m & ((1u << k) - 1)), q + 1 + k);
+        }else{
+            writer.put(1, ESCAPE_LIMIT + 1);
+            writer.put(m, 8);
+        }
+    });
+    return writer.finish();
+}
+
+void RiceCoder::decodeInto(const u8 *bytes, u64 size, u8 *out, u64 code_num) const {
+    BitReader reader(bytes, size);
+    run(out, code_num, [&](u64 i, u8 pred, u32 k){
+        u32 q = leading_zeros(reader.peek(32));
+        u32 m;
+        if(q < ESCAPE_LIMIT){
+            reader.skip(q + 1);
+            m = (q << k) | reader.read(k);
+        }else if(q == ESCAPE_LIMIT){
+            reader.skip(ESCAPE_LIMIT + 1);
+            m = reader.read(8);
+        }else{
+            Logger::getInstance().error("Invalid bit sequence");
+            throw std::runtime_error("Invalid bit sequence");
+        }
+        out[i] = unfold(m, pred);
+    });
+    if(reader.overrun() || (reader.bitSize() - reader.tell()) >= 8){
+        Logger::getInstance().error("Decoded count not equal to code number");
+        throw std::runtime_error("Decoded count not equal to code number");
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef RICECODER_H
+#define RICECODER_H
+
+#include <vector>
+#include <stdexcept>
+
+typedef unsigned char u8;
+typedef unsigned int u32;
+typedef unsigned long long u64;
+
+// 自适应Golomb-Rice编码器（LOCO-I风格）
+// 先用MED预测器得到残差，再按局部梯度选择上下文，
+// 每个上下文根据历史残差均值自适应选择Rice参数k，无需码表
+class RiceCoder
+{
+public:
+    // 量化梯度级数 × 最多4个通道
+    static constexpr u32 ACTIVITY_LEVELS = 8;
+    static constexpr u32 MAX_CHANNELS = 4;
+    static constexpr u32 CONTEXT_COUNT = ACTIVITY_LEVELS * MAX_CHANNELS + 1;
+
+    // 一元部分的最大长度，超过时直接写8位原值
+    static constexpr u32 ESCAPE_LIMIT = 16;
+
+    // 上下文统计在计数达到该值时减半，跟踪局部变化
+    static constexpr u32 RESET_THRESHOLD = 64;
+
+    std::vector<u8> encode(const u8 *data, u64 size) const;
+    std::vector<u8> encode(const std::vector<u8> &data) const { return encode(data.data(), data.size()); }
+
+    // 解码code_num字节写入out，预测时读取out中已解出的相邻像素
+    void decodeInto(const u8 *bytes, u64 size, u8 *out, u64 code_num) const;
+    std::vector<u8> decode(const std::vector<u8> &bytes, u64 code_num) const {
+        std::vector<u8> result(code_num);
+        decodeInto(bytes.data(), bytes.size(), result.data(), code_num);
+        return result;
+    }
+
+private:
+    struct Context
+    {
+        u32 a; // 残差累计
+        u32 n; // 出现次数
+    };
+
+    // 只读取data：编码时为输入；解码时为输出，coder先写出第i字节，之后才读取它
+    template <typename Coder>
+    void run(const u8 *data, u64 size, Coder &&coder) const;
+};
+
+#endif // RICECODER_H
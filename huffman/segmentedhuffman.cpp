@@ -0,0 +1,278 @@
+#include "segmentedhuffman.h"
+#include "bitio.h"
+#include "../logger/Logger.h"
+#include "../FileStream/CopyCounter.h"
+#include <algorithm>
+
+static void write_varint(std::vector<u8> &out, u64 value){
+    do{
+        u8 byte = value & 0x7F;
+        value >>= 7;
+        out.push_back(value ? (byte | 0x80) : byte);
+    }while(value);
+}
+
+static void invalid_directory(){
+    Logger::getInstance().error("Invalid segment directory");
+    throw std::runtime_error("Invalid segment directory");
+}
+
+static u64 read_varint(const u8 *bytes, size_t size, size_t &position){
+    u64 value = 0;
+    for(u32 shift = 0;; shift += 7){
+        if(position >= size || shift > 56){
+            invalid_directory();
+        }
+        u8 byte = bytes[position++];
+        value |= static_cast<u64>(byte & 0x7F) << shift;
+        if(!(byte & 0x80)){
+            return value;
+        }
+    }
+}
+
+SegmentedHuffman::SegmentedHuffman(const std::vector<std::vector<u64>> &histograms) : histograms(histograms){
+    if(histograms.size() > MAX_TABLES){
+        Logger::getInstance().error("Too many tables");
+        throw std::runtime_error("Too many tables");
+    }
+    build();
+}
+
+SegmentedHuffman::SegmentedHuffman(const std::unordered_map<u64, u64> &frequency_map){
+    for(const auto &entry : frequency_map){
+        u64 table = entry.first >> 8;
+        if(table >= MAX_TABLES){
+            Logger::getInstance().error("Invalid table in frequency map");
+            throw std::runtime_error("Invalid table in frequency map");
+        }
+        if(table >= histograms.size()){
+            histograms.resize(table + 1, std::vector<u64>(256, 0));
+        }
+        histograms[table][entry.first & 0xFF] = entry.second;
+    }
+    build();
+}
+
+void SegmentedHuffman::build(){
+    trees.clear();
+    lookups.clear();
+    codes.assign(histograms.size(), std::vector<std::pair<u64, u8>>(256, std::make_pair(0, 0)));
+    for(size_t t = 0; t < histograms.size(); t++){
+        // 与按字节静态哈夫曼相同的建树输入，同样的频数得到同样的编码，编码数据可以原样复制。
+        // 因此与静态哈夫曼一样不限制码长，超过32位的编码由HuffmanLookup逐位读出
+        std::unordered_map<u8, u64> frequency_map;
+        for(u32 s = 0; s < 256; s++){
+            if(histograms[t][s] > 0){
+                frequency_map[static_cast<u8>(s)] = histograms[t][s];
+            }
+        }
+        if(frequency_map.empty()){
+            trees.emplace_back();
+            lookups.emplace_back();
+            continue;
+        }
+        std::unique_ptr<HuffmanTree<u8>> tree(new HuffmanTree<u8>());
+        tree->input_data(frequency_map);
+        tree->spawnTree();
+        for(auto &code : tree->get_code_map()){
+            codes[t][code.first] = code.second;
+        }
+        lookups.emplace_back(new HuffmanLookup<u8>(tree->get_root()));
+        trees.push_back(std::move(tree));
+    }
+}
+
+const HuffmanLookup<u8> &SegmentedHuffman::lookup(u8 table) const {
+    if(table >= lookups.size() || !lookups[table]){
+        invalid_directory();
+    }
+    return *lookups[table];
+}
+
+SegmentedHuffman::Segment SegmentedHuffman::encodeSegment(const u8 *data, u64 length, u8 table, std::vector<u8> &payload) const {
+    if(table >= codes.size() || !lookups[table]){
+        Logger::getInstance().error("Invalid table for segment");
+        throw std::runtime_error("Invalid table for segment");
+    }
+    const std::vector<std::pair<u64, u8>> &table_codes = codes[table];
+    const std::vector<u64> &histogram = histograms[table];
+    // 位流直接接在payload之后写出，不经过单独的缓冲再复制一次
+    const size_t position = payload.size();
+    const size_t needed = position + encode_reserve(length);
+    if(payload.capacity() < needed){
+        // 按倍数扩容，连续追加多段时不会每段都重新分配
+        payload.reserve(std::max(payload.capacity() * 2, needed));
+    }
+    BitWriter writer(std::move(payload));
+    for(u64 i = 0; i < length; i++){
+        if(histogram[data[i]] == 0){
+            Logger::getInstance().error("Symbol not in table");
+            throw std::runtime_error("Symbol not in table");
+        }
+        const std::pair<u64, u8> &code = table_codes[data[i]];
+        writer.put(code.first, code.second);
+    }
+    payload = writer.finish();
+    Segment segment{length, table, payload.size() - position, position};
+    return segment;
+}
+
+u64 SegmentedHuffman::skip(const u8 *bytes, size_t size, u64 bit_offset, u8 table, u64 symbols) const {
+    const HuffmanLookup<u8> &decoder = lookup(table);
+    if(bit_offset > static_cast<u64>(size) * 8){
+        invalid_directory();
+    }
+    BitReader reader(bytes + bit_offset / 8, size - bit_offset / 8);
+    reader.skip(bit_offset % 8);
+    for(u64 i = 0; i < symbols; i++){
+        decoder.decode(reader);
+    }
+    if(reader.overrun()){
+        Logger::getInstance().error("Segment shorter than its length");
+        throw std::runtime_error("Segment shorter than its length");
+    }
+    return bit_offset / 8 * 8 + reader.tell();
+}
+
+void SegmentedHuffman::decodeRange(const u8 *bytes, size_t size, u64 bit_offset, u8 table, u8 *out, u64 length) const {
+    const HuffmanLookup<u8> &decoder = lookup(table);
+    if(bit_offset > static_cast<u64>(size) * 8){
+        invalid_directory();
+    }
+    BitReader reader(bytes + bit_offset / 8, size - bit_offset / 8);
+    reader.skip(bit_offset % 8);
+    for(u64 i = 0; i < length; i++){
+        out[i] = decoder.decode(reader);
+    }
+    if(reader.overrun()){
+        Logger::getInstance().error("Segment shorter than its length");
+        throw std::runtime_error("Segment shorter than its length");
+    }
+}
+
+std::vector<u8> SegmentedHuffman::assemble(const std::vector<Segment> &segments, std::vector<u8> &&payload){
+    std::vector<u8> bytes;
+    u32 count = static_cast<u32>(segments.size());
+    for(int b = 0; b < 4; b++){
+        bytes.push_back((count >> (8 * b)) & 0xFF);
+    }
+    for(const Segment &segment : segments){
+        write_varint(bytes, segment.length);
+        bytes.push_back(segment.table);
+        write_varint(bytes, segment.coded_bytes);
+    }
+    // 目录插到位流前面：容量足够时在原缓冲中移动，不另外分配一份位流
+    CopyCounter::add(payload.size() + bytes.size());
+    payload.insert(payload.begin(), bytes.begin(), bytes.end());
+    return std::move(payload);
+}
+
+std::vector<SegmentedHuffman::Segment> SegmentedHuffman::parseDirectory(const u8 *bytes, size_t size){
+    if(size < 4){
+        invalid_directory();
+    }
+    u32 count = 0;
+    for(int b = 3; b >= 0; b--){
+        count = (count << 8) | bytes[b];
+    }
+    size_t position = 4;
+    std::vector<Segment> segments;
+    for(u32 i = 0; i < count; i++){
+        Segment segment;
+        segment.length = read_varint(bytes, size, position);
+        if(position >= size){
+            invalid_directory();
+        }
+        segment.table = bytes[position++];
+        segment.coded_bytes = read_varint(bytes, size, position);
+        segment.position = 0;
+        segments.push_back(segment);
+    }
+    u64 offset = position;
+    for(Segment &segment : segments){
+        if(segment.coded_bytes > size - offset){
+            invalid_directory();
+        }
+        segment.position = offset;
+        offset += segment.coded_bytes;
+    }
+    if(offset != size){
+        invalid_directory();
+    }
+    return segments;
+}
+
+void SegmentedHuffman::decodeInto(const u8 *bytes, size_t size, u8 *out, u64 code_num) const {
+    std::vector<Segment> segments = parseDirectory(bytes, size);
+    u64 offset = 0;
+    for(const Segment &segment : segments){
+        if(segment.length > code_num - offset){
+            invalid_directory();
+        }
+        const HuffmanLookup<u8> &decoder = lookup(segment.table);
+        BitReader reader(bytes + segment.position, segment.coded_bytes);
+        for(u64 end = offset + segment.length; offset < end; offset++){
+            out[offset] = decoder.decode(reader);
+        }
+        if(reader.overrun() || (reader.bitSize() - reader.tell()) >= 8){
+            Logger::getInstance().error("Decoded count not equal to code number");
+            throw std::runtime_error("Decoded count not equal to code number");
+        }
+    }
+    if(offset != code_num){
+        Logger::getInstance().error("Decoded count not equal to code number");
+        throw std::runtime_error("Decoded count not equal to code number");
+    }
+}
+
+void SegmentedHuffman::copyBits(const u8 *bytes, size_t size, u64 bit_offset, u64 bit_count, std::vector<u8> &payload){
+    if(bit_offset + bit_count > static_cast<u64>(size) * 8){
+        Logger::getInstance().error("Bit range out of bounds");
+        throw std::runtime_error("Bit range out of bounds");
+    }
+    if(bit_offset % 8 == 0){
+        // 起点对齐时直接整字节复制，只需清掉最后一个字节中范围之外的位
+        const u8 *begin = bytes + bit_offset / 8;
+        payload.insert(payload.end(), begin, begin + (bit_count + 7) / 8);
+        CopyCounter::add((bit_count + 7) / 8);
+        if(bit_count % 8 != 0){
+            payload.back() &= static_cast<u8>(0xFF << (8 - bit_count % 8));
+        }
+        return;
+    }
+    BitReader reader(bytes + bit_offset / 8, size - bit_offset / 8);
+    reader.skip(bit_offset % 8);
+    BitWriter writer;
+    writer.reserve(bit_count / 8 + 8);
+    for(; bit_count >= 32; bit_count -= 32){
+        writer.put(reader.read(32), 32);
+    }
+    writer.put(reader.read(static_cast<u32>(bit_count)), static_cast<u32>(bit_count));
+    std::vector<u8> copied = writer.finish();
+    payload.insert(payload.end(), copied.begin(), copied.end());
+    // 移位写出一次，追加到payload再一次
+    CopyCounter::add(2 * copied.size());
+}
+
+std::unordered_map<u64, u64> SegmentedHuffman::get_frequency_map() const {
+    std::unordered_map<u64, u64> frequency_map;
+    for(size_t t = 0; t < histograms.size(); t++){
+        for(u32 s = 0; s < 256; s++){
+            if(histograms[t][s] > 0){
+                frequency_map[(static_cast<u64>(t) << 8) | s] = histograms[t][s];
+            }
+        }
+    }
+    return frequency_map;
+}
+
+u8 SegmentedHuffman::get_frequency_length() const {
+    u8 length = 1;
+    for(const auto &tree : trees){
+        if(tree && tree->get_frequency_length() > length){
+            length = tree->get_frequency_length();
+        }
+    }
+    return length;
+}
@@ -0,0 +1,80 @@
+#ifndef SEGMENTEDHUFFMAN_H
+#define SEGMENTEDHUFFMAN_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "huffmantree.h"
+#include "huffmanlookup.h"
+
+// 分段静态哈夫曼编码
+// 数据由若干段组成，每段从共享码表中选择一张。各段的位流按字节对齐，目录中记录每段的原始长度和编码后字节数，
+// 不解码就能定位任意一段：拼接、切分、裁剪时整段复制编码数据，只有切口所在的段需要找出位偏移，
+// 新的BMP文件头作为边界单独编码
+class SegmentedHuffman
+{
+public:
+    // 码表数量上限，编号写在目录中占1字节
+    static constexpr u32 MAX_TABLES = 255;
+
+    struct Segment
+    {
+        u64 length;      // 原始字节数
+        u8 table;
+        u64 coded_bytes; // 编码后字节数（含末尾补齐）
+        u64 position;    // 位流在位集中的起点（字节），解析目录时填写
+    };
+
+    // 编码端：每张码表一个256项直方图，直方图为空的码表不可被段引用
+    explicit SegmentedHuffman(const std::vector<std::vector<u64>> &histograms);
+
+    // 解码端：键为 (码表编号 << 8) | 符号
+    explicit SegmentedHuffman(const std::unordered_map<u64, u64> &frequency_map);
+
+    // 用table编码length字节并追加到payload（按字节补齐），返回段描述
+    Segment encodeSegment(const u8 *data, u64 length, u8 table, std::vector<u8> &payload) const;
+
+    // 从bytes的bit_offset开始跳过symbols个符号后的位偏移（只解码码长，不输出）
+    u64 skip(const u8 *bytes, size_t size, u64 bit_offset, u8 table, u64 symbols) const;
+
+    // 从bytes的bit_offset开始解出length字节
+    void decodeRange(const u8 *bytes, size_t size, u64 bit_offset, u8 table, u8 *out, u64 length) const;
+
+    // 输出：目录 + 各段位流
+    // 目录为 段数(u32小端)，随后每段 原始长度(LEB128) + 码表编号(1字节) + 编码后字节数(LEB128)
+    // 结果就地建在payload的缓冲上
+    static std::vector<u8> assemble(const std::vector<Segment> &segments, std::vector<u8> &&payload);
+
+    static std::vector<Segment> parseDirectory(const u8 *bytes, size_t size);
+    static std::vector<Segment> parseDirectory(const std::vector<u8> &bytes) { return parseDirectory(bytes.data(), bytes.size()); }
+
+    void decodeInto(const u8 *bytes, size_t size, u8 *out, u64 code_num) const;
+    std::vector<u8> decode(const std::vector<u8> &bytes, u64 code_num) const {
+        std::vector<u8> result(code_num);
+        decodeInto(bytes.data(), bytes.size(), result.data(), code_num);
+        return result;
+    }
+
+    // 把bytes中[bit_offset, bit_offset + bit_count)的位按字节对齐追加到payload，补齐位为0
+    static void copyBits(const u8 *bytes, size_t size, u64 bit_offset, u64 bit_count, std::vector<u8> &payload);
+
+    std::unordered_map<u64, u64> get_frequency_map() const;
+
+    u8 get_frequency_length() const;
+
+    u32 get_table_count() const { return static_cast<u32>(histograms.size()); }
+
+    const std::vector<u64> &get_histogram(u8 table) const { return histograms[table]; }
+
+private:
+    std::vector<std::vector<u64>> histograms;
+    std::vector<std::unique_ptr<HuffmanTree<u8>>> trees;
+    std::vector<std::unique_ptr<HuffmanLookup<u8>>> lookups;
+    std::vector<std::vector<std::pair<u64, u8>>> codes;
+
+    void build();
+
+    const HuffmanLookup<u8> &lookup(u8 table) const;
+};
+
+#endif // SEGMENTEDHUFFMAN_H
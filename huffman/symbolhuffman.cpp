@@ -0,0 +1,191 @@
+#include "symbolhuffman.h"
+#include "bitio.h"
+#include "bmplayout.h"
+#include "../logger/Logger.h"
+#include <cmath>
+
+u32 SymbolHuffman::symbolAt(const u8 *data, u64 size, u64 i, u8 symbol_bits){
+    switch(symbol_bits){
+        case 4:{
+            u8 byte = data[i >> 1];
+            return (i & 1) ? (byte & 0x0F) : (byte >> 4);
+        }
+        case 16:{
+            u64 pos = i << 1;
+            u32 high = pos + 1 < size ? data[pos + 1] : 0;
+            return data[pos] | (high << 8);
+        }
+        default:
+            return data[i];
+    }
+}
+
+std::vector<u64> SymbolHuffman::histogram(const u8 *data, u64 size, u8 symbol_bits){
+    std::vector<u64> counts(1u << symbol_bits, 0);
+    u64 count = symbolCount(size, symbol_bits);
+    for(u64 i = 0; i < count; i++){
+        counts[symbolAt(data, size, i, symbol_bits)]++;
+    }
+    return counts;
+}
+
+double SymbolHuffman::estimateBits(const u8 *data, u64 size, u8 symbol_bits){
+    std::vector<u64> counts = histogram(data, size, symbol_bits);
+    u64 total = symbolCount(size, symbol_bits);
+    // 每个出现的符号在码表中占 键 + 值，值的字节数由最大频数决定
+    u64 max_count = 0;
+    for(u64 count : counts){
+        max_count = count > max_count ? count : max_count;
+    }
+    u32 value_size = max_count >= 65536 ? (max_count >= 4294967296ull ? 8 : 4) : (max_count >= 256 ? 2 : 1);
+    const double entry_bits = ((symbol_bits > 8 ? 2 : 1) + value_size) * 8;
+    double bits = 0;
+    for(u64 count : counts){
+        if(count > 0){
+            bits += count * std::log2(static_cast<double>(total) / count) + entry_bits;
+        }
+    }
+    return bits;
+}
+
+u8 SymbolHuffman::chooseSymbolBits(const u8 *data, u64 size){
+    BmpLayout layout = BmpLayout::parse(data, size);
+    u8 candidate = 8;
+    if(layout.bit_count == 16 || layout.bit_count == 1){
+        candidate = 16;
+    }else if(layout.bit_count == 4){
+        candidate = 4;
+    }
+    if(candidate == 8){
+        return 8;
+    }
+    double candidate_bits = estimateBits(data, size, candidate);
+    double byte_bits = estimateBits(data, size, 8);
+    Logger::getInstance().debug("符号宽度估算 - " + std::to_string(candidate) + "位: " + std::to_string(static_cast<u64>(candidate_bits / 8)) +
+                                " 字节, 8位: " + std::to_string(static_cast<u64>(byte_bits / 8)) + " 字节");
+    return candidate_bits < byte_bits ? candidate : 8;
+}
+
+SymbolHuffman::SymbolHuffman(const u8 *data, u64 size, u8 symbol_bits) : symbol_bits(symbol_bits){
+    if(!validSymbolBits(symbol_bits)){
+        Logger::getInstance().error("Invalid symbol bits: " + std::to_string(symbol_bits));
+        throw std::runtime_error("Invalid symbol bits");
+    }
+    // 频数悬殊时码长可能超过查表解码的上限，码表用压平后的频数，位数仍按真实频数计算
+    std::vector<u64> counts = histogram(data, size, symbol_bits);
+    std::vector<u64> table_counts(counts);
+    if(limit_code_length<u16>(table_counts, TABLE_CODE_BITS)){
+        Logger::getInstance().debug(std::to_string(symbol_bits) + "位符号码长超过 " + std::to_string(TABLE_CODE_BITS) + " 位，已压平频数");
+    }
+    build(table_counts);
+    encoded_bits = countBits(counts);
+}
+
+SymbolHuffman::SymbolHuffman(u8 symbol_bits, const std::unordered_map<u64, u64> &frequency_map) : symbol_bits(symbol_bits){
+    if(!validSymbolBits(symbol_bits)){
+        Logger::getInstance().error("Invalid symbol bits: " + std::to_string(symbol_bits));
+        throw std::runtime_error("Invalid symbol bits");
+    }
+    std::vector<u64> counts(1u << symbol_bits, 0);
+    for(const auto &entry : frequency_map){
+        if(entry.first >= counts.size()){
+            Logger::getInstance().error("Invalid symbol in frequency map");
+            throw std::runtime_error("Invalid symbol in frequency map");
+        }
+        counts[entry.first] = entry.second;
+    }
+    build(counts);
+    encoded_bits = countBits(counts);
+}
+
+void SymbolHuffman::build(const std::vector<u64> &counts){
+    // 只把出现过的符号交给HuffmanTree，避免对稠密数组逐个插入
+    std::unordered_map<u16, u64> frequency_map;
+    for(size_t s = 0; s < counts.size(); s++){
+        if(counts[s] > 0){
+            frequency_map[static_cast<u16>(s)] = counts[s];
+        }
+    }
+    if(frequency_map.empty()){
+        Logger::getInstance().error("Empty frequency map");
+        throw std::runtime_error("Empty frequency map");
+    }
+    tree.reset(new HuffmanTree<u16>());
+    tree->input_data(frequency_map);
+    tree->spawnTree();
+
+    codes.assign(counts.size(), std::make_pair(0, 0));
+    for(auto &code : tree->get_code_map()){
+        if(code.second.second > TABLE_CODE_BITS){
+            Logger::getInstance().error("Huffman code longer than 32 bits");
+            throw std::runtime_error("Huffman code longer than 32 bits");
+        }
+        codes[code.first] = code.second;
+    }
+    lookup.reset(new HuffmanTrie<u16>(tree->get_root()));
+}
+
+std::vector<u8> SymbolHuffman::encode(const u8 *data, u64 size) const {
+    BitWriter writer;
+    writer.reserve(encode_reserve(size));
+    u64 count = symbolCount(size, symbol_bits);
+    for(u64 i = 0; i < count; i++){
+        const std::pair<u64, u8> &code = codes[symbolAt(data, size, i, symbol_bits)];
+        writer.put(code.first, code.second);
+    }
+    return writer.finish();
+}
+
+std::vector<u8> SymbolHuffman::decode(const u8 *bytes, u64 size, u64 byte_num) const {
+    std::vector<u8> result(byte_num);
+    decodeInto(bytes, size, result.data(), byte_num);
+    return result;
+}
+
+void SymbolHuffman::decodeInto(const u8 *bytes, u64 size, u8 *out, u64 byte_num) const {
+    u64 count = symbolCount(byte_num, symbol_bits);
+    BitReader reader(bytes, size);
+    for(u64 i = 0; i < count; i++){
+        u16 symbol = lookup->decode(reader);
+        switch(symbol_bits){
+            case 4:
+                // 先写高半字节再并入低半字节，out不需要预先清零
+                if(i & 1){
+                    out[i >> 1] |= symbol;
+                }else{
+                    out[i >> 1] = static_cast<u8>(symbol << 4);
+                }
+                break;
+            case 16:
+                out[i << 1] = static_cast<u8>(symbol);
+                // 奇数字节数时最后一个符号的高字节是补齐的0
+                if((i << 1) + 1 < byte_num){
+                    out[(i << 1) + 1] = static_cast<u8>(symbol >> 8);
+                }
+                break;
+            default:
+                out[i] = static_cast<u8>(symbol);
+                break;
+        }
+    }
+    if(reader.overrun() || (reader.bitSize() - reader.tell()) >= 8){
+        Logger::getInstance().error("Decoded count not equal to code number");
+        throw std::runtime_error("Decoded count not equal to code number");
+    }
+}
+
+u64 SymbolHuffman::countBits(const std::vector<u64> &counts) const {
+    u64 bits = 0;
+    for(size_t s = 0; s < counts.size(); s++){
+        bits += counts[s] * codes[s].second;
+    }
+    return bits;
+}
+
+std::unordered_map<u64, u64> SymbolHuffman::get_frequency_map() const {
+    std::unordered_map<u64, u64> frequency_map;
+    for(auto &entry : tree->get_frequency_map()){
+        frequency_map[entry.first] = entry.second;
+    }
+    return frequency_map;
+}
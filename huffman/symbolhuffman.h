@@ -0,0 +1,72 @@
+#ifndef SYMBOLHUFFMAN_H
+#define SYMBOLHUFFMAN_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "huffmantree.h"
+#include "huffmantrie.h"
+
+// 按像素位深选择符号宽度的静态哈夫曼编码
+// 16位像素以u16为符号，4位像素以半字节为符号，1位像素每16个像素组成一个u16符号；
+// 直方图和码表都是按符号值索引的稠密数组，65536个符号的字母表也不需要逐个查哈希表
+class SymbolHuffman
+{
+public:
+    // 编码端：把字节流切分为symbol_bits位的符号（4、8或16，小端，末尾补0）并建树
+    SymbolHuffman(const u8 *data, u64 size, u8 symbol_bits);
+    SymbolHuffman(const std::vector<u8> &data, u8 symbol_bits) : SymbolHuffman(data.data(), data.size(), symbol_bits) {}
+
+    // 解码端：由文件中保存的频数表重建
+    SymbolHuffman(u8 symbol_bits, const std::unordered_map<u64, u64> &frequency_map);
+
+    std::vector<u8> encode(const u8 *data, u64 size) const;
+    std::vector<u8> encode(const std::vector<u8> &data) const { return encode(data.data(), data.size()); }
+
+    // byte_num为原始字节数，返回值按该长度截断
+    std::vector<u8> decode(const u8 *bytes, u64 size, u64 byte_num) const;
+    std::vector<u8> decode(const std::vector<u8> &bytes, u64 byte_num) const { return decode(bytes.data(), bytes.size(), byte_num); }
+
+    // 解码到out的byte_num字节
+    void decodeInto(const u8 *bytes, u64 size, u8 *out, u64 byte_num) const;
+
+    std::unordered_map<u64, u64> get_frequency_map() const;
+
+    u8 get_frequency_length() { return tree->get_frequency_length(); }
+
+    // 编码全部符号的精确位数（频数乘码长之和），不需要实际编码
+    u64 get_encoded_bits() const { return encoded_bits; }
+
+    u8 get_symbol_bits() const { return symbol_bits; }
+
+    // 键在文件中占用的字节数
+    u8 get_key_size() const { return symbol_bits > 8 ? 2 : 1; }
+
+    static bool validSymbolBits(u8 symbol_bits) { return symbol_bits == 4 || symbol_bits == 8 || symbol_bits == 16; }
+
+    // 根据BMP位深给出候选宽度，再按估算的压缩后大小（含码表）与按字节编码比较
+    static u8 chooseSymbolBits(const u8 *data, u64 size);
+    static u8 chooseSymbolBits(const std::vector<u8> &data) { return chooseSymbolBits(data.data(), data.size()); }
+
+    // 估算用symbol_bits位符号编码的总位数：经验熵加码表开销
+    static double estimateBits(const u8 *data, u64 size, u8 symbol_bits);
+
+private:
+    u8 symbol_bits;
+    std::unique_ptr<HuffmanTree<u16>> tree;
+    std::unique_ptr<HuffmanTrie<u16>> lookup;
+    std::vector<std::pair<u64, u8>> codes;    // 符号 -> (编码, 编码长度)
+    u64 encoded_bits = 0;                      // 按真实频数（不是压平后的码表频数）计算的位数
+
+    void build(const std::vector<u64> &histogram);
+
+    u64 countBits(const std::vector<u64> &counts) const;
+
+    static std::vector<u64> histogram(const u8 *data, u64 size, u8 symbol_bits);
+
+    static u64 symbolCount(u64 byte_num, u8 symbol_bits) { return (byte_num * 8 + symbol_bits - 1) / symbol_bits; }
+
+    static u32 symbolAt(const u8 *data, u64 size, u64 i, u8 symbol_bits);
+};
+
+#endif // SYMBOLHUFFMAN_H
@@ -0,0 +1,250 @@
+#include "tans.h"
+#include "bitio.h"
+#include "../logger/Logger.h"
+#include <algorithm>
+#include <cstring>
+
+// 最高有效位的位置（x > 0）
+static inline u32 highbit(u32 x){
+    u32 n = 0;
+    while(x >>= 1){
+        n++;
+    }
+    return n;
+}
+
+u8 TansCoder::choose_table_log(const std::unordered_map<u8, u64> &frequency_map){
+    u64 total = 0;
+    for(auto &data : frequency_map){
+        total += data.second;
+    }
+    // 表不必比数据量大太多，小文件用小表
+    u32 log = MAX_TABLE_LOG;
+    if(total > 0){
+        u32 by_size = highbit(static_cast<u32>(std::min<u64>(total, 1u << 30))) + 1;
+        log = std::min(log, by_size);
+    }
+    // 表必须能容纳所有出现过的符号
+    u32 by_symbols = highbit(static_cast<u32>(std::max<size_t>(frequency_map.size(), 1))) + 1;
+    log = std::max(log, by_symbols);
+    log = std::max<u32>(log, MIN_TABLE_LOG);
+    return static_cast<u8>(std::min<u32>(log, MAX_TABLE_LOG));
+}
+
+TansCoder::TansCoder(const std::unordered_map<u8, u64> &frequency_map, u8 i_table_log)
+    : table_log(i_table_log == 0 ? choose_table_log(frequency_map) : i_table_log)
+{
+    if(table_log < MIN_TABLE_LOG || table_log > MAX_TABLE_LOG){
+        throw std::runtime_error("Invalid tANS table log");
+    }
+    if((1u << table_log) < frequency_map.size()){
+        throw std::runtime_error("tANS table too small for alphabet");
+    }
+    normalize(frequency_map);
+    buildTables();
+}
+
+void TansCoder::normalize(const std::unordered_map<u8, u64> &frequency_map){
+    const u32 table_size = 1u << table_log;
+    normalized.assign(256, 0);
+
+    u64 total = 0;
+    for(auto &data : frequency_map){
+        total += data.second;
+    }
+    if(total == 0){
+        // 空数据：任意一个符号占满整张表，保证表结构合法
+        normalized[0] = table_size;
+        return;
+    }
+
+    // 按比例缩放，出现过的符号至少为1，记录舍去的余数
+    std::vector<u64> remainder(256, 0);
+    s32 distributed = 0;
+    for(auto &data : frequency_map){
+        if(data.second == 0){
+            continue;
+        }
+        u64 scaled = data.second * table_size;
+        u32 count = static_cast<u32>(scaled / total);
+        remainder[data.first] = scaled % total;
+        if(count == 0){
+            count = 1;
+            remainder[data.first] = 0;
+        }
+        normalized[data.first] = count;
+        distributed += count;
+    }
+
+    s32 diff = static_cast<s32>(table_size) - distributed;
+    if(diff > 0){
+        // 余数大的符号优先补足，余数相同按符号值，保证编解码两端一致
+        std::vector<u8> order;
+        for(u32 s = 0; s < 256; s++){
+            if(normalized[s] > 0){
+                order.push_back(static_cast<u8>(s));
+            }
+        }
+        std::stable_sort(order.begin(), order.end(), [&](u8 a, u8 b){
+            return remainder[a] > remainder[b];
+        });
+        for(size_t i = 0; diff > 0; i = (i + 1) % order.size()){
+            normalized[order[i]]++;
+            diff--;
+        }
+    }
+    while(diff < 0){
+        // 强制为1的符号过多时，从最大的符号中扣除
+        u32 largest = 0;
+        for(u32 s = 1; s < 256; s++){
+            if(normalized[s] > normalized[largest]){
+                largest = s;
+            }
+        }
+        if(normalized[largest] <= 1){
+            throw std::runtime_error("tANS normalization failed");
+        }
+        normalized[largest]--;
+        diff++;
+    }
+}
+
+void TansCoder::buildTables(){
+    const u32 table_size = 1u << table_log;
+    const u32 table_mask = table_size - 1;
+    const u32 step = (table_size >> 1) + (table_size >> 3) + 3;
+
+    // 按固定步长把符号散布到状态表中，使同一符号的状态分布均匀
+    std::vector<u8> table_symbol(table_size);
+    u32 position = 0;
+    for(u32 s = 0; s < 256; s++){
+        for(u32 i = 0; i < normalized[s]; i++){
+            table_symbol[position] = static_cast<u8>(s);
+            position = (position + step) & table_mask;
+        }
+    }
+    if(position != 0){
+        throw std::runtime_error("tANS symbol spread failed");
+    }
+
+    // 编码状态表：按符号分段，段内按状态顺序排列
+    std::vector<u32> cumulative(257, 0);
+    for(u32 s = 0; s < 256; s++){
+        cumulative[s + 1] = cumulative[s] + normalized[s];
+    }
+    state_table.assign(table_size, 0);
+    std::vector<u32> next_slot(cumulative.begin(), cumulative.end() - 1);
+    for(u32 u = 0; u < table_size; u++){
+        state_table[next_slot[table_symbol[u]]++] = static_cast<u16>(table_size + u);
+    }
+
+    symbol_tt.assign(256, SymbolTransform{0, 0});
+    for(u32 s = 0; s < 256; s++){
+        u32 count = normalized[s];
+        if(count == 0){
+            continue;
+        }
+        if(count == 1){
+            symbol_tt[s].delta_nb_bits = (static_cast<u32>(table_log) << 16) - table_size;
+            symbol_tt[s].delta_find_state = static_cast<s32>(cumulative[s]) - 1;
+        }else{
+            u32 max_bits_out = table_log - highbit(count - 1);
+            u32 min_state_plus = count << max_bits_out;
+            symbol_tt[s].delta_nb_bits = (max_bits_out << 16) - min_state_plus;
+            symbol_tt[s].delta_find_state = static_cast<s32>(cumulative[s]) - static_cast<s32>(count);
+        }
+    }
+
+    // 解码表：状态 -> (符号, 需读取的位数, 下一状态基数)
+    decode_table.assign(table_size, DecodeEntry{0, 0, 0});
+    std::vector<u32> symbol_next(normalized.begin(), normalized.end());
+    for(u32 u = 0; u < table_size; u++){
+        u8 s = table_symbol[u];
+        u32 x = symbol_next[s]++;
+        u8 nb_bits = static_cast<u8>(table_log - highbit(x));
+        decode_table[u].symbol = s;
+        decode_table[u].nb_bits = nb_bits;
+        decode_table[u].new_state = static_cast<u16>((x << nb_bits) - table_size);
+    }
+}
+
+std::vector<u8> TansCoder::encode(const u8 *data, u64 size) const {
+    std::vector<u8> result;
+    result.reserve(encode_reserve(size));
+
+    const u32 table_size = 1u << table_log;
+    u64 buffer = 0;       // 低位先出的位缓冲区
+    u32 buffer_bits = 0;
+
+    auto put_bits = [&](u32 value, u32 nb_bits){
+        buffer |= static_cast<u64>(value & ((1u << nb_bits) - 1)) << buffer_bits;
+        buffer_bits += nb_bits;
+        while(buffer_bits >= 8){
+            result.push_back(static_cast<u8>(buffer));
+            buffer >>= 8;
+            buffer_bits -= 8;
+        }
+    };
+
+    u32 state = table_size;
+    for(u64 i = size; i-- > 0;){
+        if(normalized[data[i]] == 0){
+            throw std::runtime_error("Code not found for data element");
+        }
+        const SymbolTransform &tt = symbol_tt[data[i]];
+        u32 nb_bits = (state + tt.delta_nb_bits) >> 16;
+        put_bits(state, nb_bits);
+        state = state_table[static_cast<s32>(state >> nb_bits) + tt.delta_find_state];
+    }
+
+    // 终止状态和哨兵位，解码器从这里开始向前读
+    put_bits(state - table_size, table_log);
+    put_bits(1, 1);
+    if(buffer_bits > 0){
+        result.push_back(static_cast<u8>(buffer));
+    }
+    return result;
+}
+
+void TansCoder::decodeInto(const u8 *bytes, u64 size, u8 *out, u64 code_num) const {
+    if(size == 0 || bytes[size - 1] == 0){
+        Logger::getInstance().error("Invalid tANS bit sequence");
+        throw std::runtime_error("Invalid tANS bit sequence");
+    }
+
+    const u8 *src = bytes;
+    // 哨兵位以下的位都是有效数据
+    u64 bit_pos = (size - 1) * 8 + highbit(bytes[size - 1]);
+
+    auto read_bits = [&](u32 nb_bits) -> u32 {
+        if(bit_pos < nb_bits){
+            throw std::runtime_error("Invalid tANS bit sequence");
+        }
+        bit_pos -= nb_bits;
+        size_t byte_pos = static_cast<size_t>(bit_pos >> 3);
+        u32 window = 0;
+        if(byte_pos + 4 <= size){
+            std::memcpy(&window, src + byte_pos, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            window = __builtin_bswap32(window);
+#endif
+        }else{
+            for(size_t i = 0; byte_pos + i < size && i < 4; i++){
+                window |= static_cast<u32>(src[byte_pos + i]) << (i * 8);
+            }
+        }
+        return (window >> (bit_pos & 7)) & ((1u << nb_bits) - 1);
+    };
+
+    u32 state = read_bits(table_log);
+    for(u64 i = 0; i < code_num; i++){
+        const DecodeEntry &entry = decode_table[state];
+        out[i] = entry.symbol;
+        state = entry.new_state + read_bits(entry.nb_bits);
+    }
+
+    if(bit_pos != 0){
+        Logger::getInstance().error("tANS bitstream not fully consumed");
+        throw std::runtime_error("Decoded count not equal to code number");
+    }
+}
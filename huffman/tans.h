@@ -0,0 +1,73 @@
+#ifndef TANS_H
+#define TANS_H
+
+#include <unordered_map>
+#include <vector>
+#include <stdexcept>
+
+typedef unsigned char u8;
+typedef unsigned short u16;
+typedef unsigned int u32;
+typedef int s32;
+typedef unsigned long long u64;
+
+// 表驱动ANS（tANS/FSE）编码器
+// 与HuffmanTree共用频数统计：频数表被归一化到2^table_log，
+// 编码与解码都只做查表和移位，每个符号可使用非整数位数
+class TansCoder
+{
+public:
+    static constexpr u8 MIN_TABLE_LOG = 5;
+    static constexpr u8 MAX_TABLE_LOG = 12;
+
+    // 根据频数表构造编解码表，table_log为0时按数据量自动选择
+    explicit TansCoder(const std::unordered_map<u8, u64> &frequency_map, u8 table_log = 0);
+
+    // 编码：逆序处理数据，位流末尾写入终止状态和哨兵位
+    std::vector<u8> encode(const u8 *data, u64 size) const;
+    std::vector<u8> encode(const std::vector<u8> &data) const { return encode(data.data(), data.size()); }
+
+    // 解码：从位流末尾向前读取，恢复code_num个符号写入out
+    void decodeInto(const u8 *bytes, u64 size, u8 *out, u64 code_num) const;
+    std::vector<u8> decode(const std::vector<u8> &bytes, u64 code_num) const {
+        std::vector<u8> result(code_num);
+        decodeInto(bytes.data(), bytes.size(), result.data(), code_num);
+        return result;
+    }
+
+    u8 get_table_log() const { return table_log; }
+
+    // 归一化后的频数（和为2^table_log）
+    const std::vector<u32> &get_normalized() const { return normalized; }
+
+    // 根据频数表选择合适的表大小
+    static u8 choose_table_log(const std::unordered_map<u8, u64> &frequency_map);
+
+private:
+    // 编码时每个符号的状态变换参数
+    struct SymbolTransform
+    {
+        u32 delta_nb_bits;
+        s32 delta_find_state;
+    };
+
+    // 解码表项：读出符号，再读nb_bits位得到下一状态
+    struct DecodeEntry
+    {
+        u16 new_state;
+        u8 symbol;
+        u8 nb_bits;
+    };
+
+    u8 table_log;
+    std::vector<u32> normalized;             // 符号 -> 归一化频数
+    std::vector<u16> state_table;            // 编码状态表
+    std::vector<SymbolTransform> symbol_tt;  // 符号 -> 变换参数
+    std::vector<DecodeEntry> decode_table;   // 解码状态表
+
+    void normalize(const std::unordered_map<u8, u64> &frequency_map);
+
+    void buildTables();
+};
+
+#endif // TANS_H
@@ -258,6 +258,45 @@ void MainWindow::on_startButton_clicked()
     }
 }
 
+// 预估按钮点击：只统计频数计算压缩后的精确大小，不写输出文件
+void MainWindow::on_estimateButton_clicked()
+{
+    if (tasks.empty()) {
+        QMessageBox::warning(this, "警告", "请先添加文件");
+        return;
+    }
+
+    for (size_t i = 0; i < tasks.size(); i++) {
+        if (tasks[i].fileType != "bmp" || tasks[i].isProcessing) {
+            continue;
+        }
+        int taskIndex = static_cast<int>(i);
+        QString filePath = tasks[i].filePath;
+        std::future<HufEstimate> future = submit_estimate(filePath.toStdString());
+
+        std::thread([=, future = std::move(future)]() mutable {
+            try {
+                HufEstimate estimate = future.get();
+                QMetaObject::invokeMethod(this, [=]() {
+                    // 任务列表可能已被修改，按路径确认仍是同一个任务
+                    if (taskIndex >= tasks.size() || tasks[taskIndex].filePath != filePath) {
+                        return;
+                    }
+                    QTableWidgetItem *ratioItem = ui->taskTable->item(taskIndex, 3);
+                    if (ratioItem) {
+                        ratioItem->setText("≈" + QString::number(estimate.ratio() * 100, 'f', 2) + "%");
+                        ratioItem->setToolTip(QString("预计大小: %1 字节\n熵下界: %2 字节")
+                                                  .arg(estimate.compressed_size)
+                                                  .arg(static_cast<qint64>(estimate.entropy_size)));
+                    }
+                }, Qt::QueuedConnection);
+            } catch (const std::exception& e) {
+                std::cerr << "预估失败: " << filePath.toStdString() << ": " << e.what() << std::endl;
+            }
+        }).detach();
+    }
+}
+
 // 处理单个文件
 void MainWindow::processFile(int taskIndex)
 {
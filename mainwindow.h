@@ -49,6 +49,7 @@ private slots:
     void on_CleanAllButton_clicked();
     void on_OutputFileButton_clicked();
     void on_startButton_clicked();
+    void on_estimateButton_clicked();
     // 删除单个任务
     void deleteTask(int row);
     // 进度更新槽
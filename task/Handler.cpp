@@ -2,92 +2,991 @@
 #include "hufHandler.h"
 #include "huffmantree.h"
 #include "bitstream.h"
+#include "tans.h"
+#include "ricecoder.h"
+#include "adaptivehuffman.h"
+#include "contexthuffman.h"
+#include "symbolhuffman.h"
+#include "pixelhuffman.h"
+#include "delta.h"
+#include "blockhuffman.h"
+#include "pretrained.h"
+#include "segmentedhuffman.h"
+#include "bmplayout.h"
+#include "bitio.h"
+#include "huffmanvalidator.h"
+#include "huffmanlookup.h"
+#include "../FileStream/MappedFile.h"
+#include "../FileStream/CopyCounter.h"
+#include <chrono>
+#include <memory>
+#include <cmath>
+#include <cstdio>
+#include <thread>
 
-bool bmpHandler::huf2bmp_start(const std::string &filename, const std::string &output_filename, double *process){
-    Logger::getInstance().info("开始HUF到BMP转换任务: " + filename + " -> " + output_filename);
-    huf *hufFile = hufHandler::load(filename);
-    
+// 按字节的静态哈夫曼解码，位集可以直接来自映射的文件，结果写入out的code_num字节
+static void decode_static_huffman(const std::unordered_map<u8, u64> &key_value, const u8 *bytes, u64 size, u8 *out, u64 code_num){
     Logger::getInstance().debug("创建霍夫曼树");
     HuffmanTree<u8> tree = HuffmanTree<u8>();
+    tree.input_data(key_value);
 
-    std::unordered_map<u8, u64> key_value;
+    Logger::getInstance().debug("构建霍夫曼树");
+    tree.spawnTree();
 
-    Logger::getInstance().debug("转换键值对数据格式");
+    Logger::getInstance().debug("创建查表解码器");
+    HuffmanLookup<u8> decoder(tree.get_root());
+    BitReader reader(bytes, size);
+
+    Logger::getInstance().debug("解码位流数据");
+    decoder.decodeInto(reader, out, code_num);
+    if(reader.overrun()){
+        Logger::getInstance().error("Decoded count not equal to code number");
+        throw std::runtime_error("Decoded count not equal to code number");
+    }
+}
+
+// 所有后端都把bitNum字节结果直接写入out，位集只读（可以来自映射的文件），不复制
+static void decode_in_place(const huf *hufFile, const u8 *bitset, u64 bitset_size, u8 *out, const std::vector<u8> *reference,
+                            const std::string &dictionary){
+    std::unordered_map<u8, u64> key_value;
     for(auto i : hufFile->key_value_data){
         key_value.insert(std::make_pair(static_cast<u8>(i.first), i.second));
     }
 
-    tree.input_data(key_value);
-    
-    Logger::getInstance().debug("构建霍夫曼树");
-    tree.spawnTree();
-
-    Logger::getInstance().debug("创建解码流");
-    BitStream<u8> decode_stream(tree.get_root());
+    switch(static_cast<HufCoder>(hufFile->coder)){
+        case HufCoder::HUFFMAN:{
+            if(hufFile->symbol_bits != 8){
+                Logger::getInstance().debug("重建" + std::to_string(hufFile->symbol_bits) + "位符号码表");
+                SymbolHuffman decoder(hufFile->symbol_bits, hufFile->key_value_data);
+                Logger::getInstance().debug("解码位流数据");
+                decoder.decodeInto(bitset, bitset_size, out, hufFile->bit_num);
+                break;
+            }
+            decode_static_huffman(key_value, bitset, bitset_size, out, hufFile->bit_num);
+            break;
+        }
+        case HufCoder::DELTA:{
+            if(reference == nullptr){
+                Logger::getInstance().error("差分文件解码需要参考图像");
+                throw std::runtime_error("Reference image required");
+            }
+            if(bitset_size < Delta::DESCRIPTOR_SIZE){
+                Logger::getInstance().error("差分文件缺少参考描述");
+                throw std::runtime_error("Missing reference descriptor");
+            }
+            u64 fingerprint, reference_size;
+            Delta::readDescriptor(bitset, fingerprint, reference_size);
+            if(reference_size != reference->size() || fingerprint != Delta::fingerprint(reference->data(), reference->size())){
+                Logger::getInstance().error("参考图像指纹不匹配");
+                throw std::runtime_error("Reference fingerprint mismatch");
+            }
+            decode_static_huffman(key_value, bitset + Delta::DESCRIPTOR_SIZE, bitset_size - Delta::DESCRIPTOR_SIZE, out, hufFile->bit_num);
 
-    Logger::getInstance().debug("解码位流数据");
-    std::vector<u8> decode_data = decode_stream.decode(hufFile->bitset, hufFile->bit_num);
+            Logger::getInstance().debug("叠加参考图像");
+            u64 overlap = std::min<u64>(hufFile->bit_num, reference->size());
+            Delta::add(out, out, reference->data(), overlap);
+            break;
+        }
+        case HufCoder::STORED:{
+            if(bitset_size != hufFile->bit_num){
+                Logger::getInstance().error("存储数据长度与原始长度不符");
+                throw std::runtime_error("Stored size mismatch");
+            }
+            std::copy(bitset, bitset + bitset_size, out);
+            break;
+        }
+        case HufCoder::ADAPTIVE:{
+            if((1ull << hufFile->coder_param) != AdaptiveHuffman::BLOCK_SIZE){
+                throw std::runtime_error("Unsupported adaptive block size");
+            }
+            // 按与编码端相同的块边界解码并更新码表
+            Logger::getInstance().debug("解码自适应哈夫曼位流数据");
+            AdaptiveHuffman decoder;
+            BitReader reader(bitset, bitset_size);
+            for(u64 offset = 0; offset < hufFile->bit_num;){
+                u64 count = std::min<u64>(decoder.nextBlockSize(), hufFile->bit_num - offset);
+                decoder.decodeBlock(reader, out + offset, count);
+                offset += count;
+            }
+            break;
+        }
+        case HufCoder::TANS:{
+            Logger::getInstance().debug("构建tANS解码表");
+            TansCoder decoder(key_value, hufFile->coder_param);
 
-    Logger::getInstance().debug("创建BMP文件对象");
-    bmp* bmpFile = new bmp();
+            Logger::getInstance().debug("解码tANS位流数据");
+            decoder.decodeInto(bitset, bitset_size, out, hufFile->bit_num);
+            break;
+        }
+        case HufCoder::RICE:{
+            Logger::getInstance().debug("解码Rice位流数据");
+            RiceCoder().decodeInto(bitset, bitset_size, out, hufFile->bit_num);
+            break;
+        }
+        case HufCoder::CONTEXT:{
+            Logger::getInstance().debug("重建上下文码表");
+            ContextHuffman decoder(hufFile->coder_param, hufFile->key_value_data);
+            Logger::getInstance().debug("解码上下文位流数据");
+            decoder.decodeInto(bitset, bitset_size, out, hufFile->bit_num);
+            break;
+        }
+        case HufCoder::PIXEL:{
+            Logger::getInstance().debug("重建整像素码表");
+            PixelHuffman decoder(hufFile->key_value_data);
+            Logger::getInstance().debug("解码整像素位流数据");
+            decoder.decodeInto(bitset, bitset_size, out, hufFile->bit_num);
+            break;
+        }
+        case HufCoder::BLOCK:{
+            Logger::getInstance().debug("重建共享码表");
+            BlockHuffman decoder(hufFile->key_value_data);
+            Logger::getInstance().debug("解码分块位流数据");
+            decoder.decodeInto(bitset, bitset_size, out, hufFile->bit_num);
+            break;
+        }
+        case HufCoder::PRETRAINED:{
+            Logger::getInstance().debug("获取预训练码表 " + std::to_string(hufFile->coder_param));
+            std::shared_ptr<const PretrainedTables::Table> table = PretrainedTables::get(hufFile->coder_param, dictionary);
+            Logger::getInstance().debug("解码位流数据");
+            PretrainedTables::decodeInto(*table, bitset, bitset_size, out, hufFile->bit_num);
+            break;
+        }
+        case HufCoder::SEGMENTED:{
+            Logger::getInstance().debug("重建分段码表");
+            SegmentedHuffman decoder(hufFile->key_value_data);
+            Logger::getInstance().debug("解码分段位流数据");
+            decoder.decodeInto(bitset, bitset_size, out, hufFile->bit_num);
+            break;
+        }
+        default:{
+            Logger::getInstance().error("未知的编码后端: " + std::to_string(hufFile->coder));
+            throw std::runtime_error("Unknown coder in HUF header");
+        }
+    }
+}
 
-    bmpFile->bit_num = decode_data.size();
-    Logger::getInstance().debug("BMP文件位数量: " + std::to_string(bmpFile->bit_num));
+std::vector<u8> bmpHandler::decodeHuf(const huf *hufFile, const std::vector<u8> *reference, const std::string &dictionary){
+    return decodeHuf(hufFile, hufFile->bitset.data(), hufFile->bitset.size(), reference, dictionary);
+}
 
-    bmpFile->filemap = decode_data;
+std::vector<u8> bmpHandler::decodeHuf(const huf *hufFile, const u8 *bitset, u64 bitset_size, const std::vector<u8> *reference,
+                                      const std::string &dictionary){
+    // 结果只分配一次，各后端直接解码到其中
+    std::vector<u8> decode_data(hufFile->bit_num);
+    decode_in_place(hufFile, bitset, bitset_size, decode_data.data(), reference, dictionary);
+    return decode_data;
+}
 
-    Logger::getInstance().debug("保存BMP文件");
-    bool result = bmpHandler::save(output_filename, bmpFile);
+void bmpHandler::decodeHufInto(const huf *hufFile, const u8 *bitset, u64 bitset_size, u8 *out, const std::vector<u8> *reference,
+                               const std::string &dictionary){
+    decode_in_place(hufFile, bitset, bitset_size, out, reference, dictionary);
+}
 
+std::vector<u8> bmpHandler::loadReference(const std::string &filename, const std::string &dictionary){
+    Logger::getInstance().info("加载参考图像: " + filename);
+    size_t dot_pos = filename.find_last_of('.');
+    if(dot_pos != std::string::npos && filename.substr(dot_pos) == ".huf"){
+        huf *hufFile = hufHandler::load(filename);
+        if(static_cast<HufCoder>(hufFile->coder) == HufCoder::DELTA){
+            delete hufFile;
+            Logger::getInstance().error("参考文件本身不能是差分文件: " + filename);
+            throw std::runtime_error("Reference must not be a delta file");
+        }
+        std::vector<u8> data;
+        try{
+            data = decodeHuf(hufFile, nullptr, dictionary);
+        }catch(...){
+            delete hufFile;
+            throw;
+        }
+        delete hufFile;
+        return data;
+    }
+    bmp *bmpFile = bmpHandler::load(filename);
+    std::vector<u8> data = std::move(bmpFile->filemap);
     delete bmpFile;
-    delete hufFile;
-    
+    return data;
+}
+
+bool bmpHandler::huf2bmp_start(const std::string &filename, const std::string &output_filename, double *process,
+                               const std::string &reference, const std::string &dictionary, const WriteOptions &output_options){
+    Logger::getInstance().info("开始HUF到BMP转换任务: " + filename + " -> " + output_filename);
+    // 只读入文件头和码表，位集直接从映射的文件解码
+    std::unique_ptr<huf> hufFile;
+    u64 bitset_offset = 0;
+    {
+        FileHeadReader reader(filename);
+        hufFile.reset(hufHandler::loadHeader(reader));
+        bitset_offset = reader.tell();
+    }
+    MappedFile input(filename);
+    if(bitset_offset > input.size() || hufFile->bitset_size > input.size() - bitset_offset){
+        Logger::getInstance().error("HUF位集大小超出文件大小");
+        throw std::runtime_error("Bitset truncated");
+    }
+    const u8 *bitset = input.data() + bitset_offset;
+
+    std::vector<u8> reference_data;
+    if(!reference.empty()){
+        reference_data = loadReference(reference, dictionary);
+    }
+    const std::vector<u8> *reference_pointer = reference.empty() ? nullptr : &reference_data;
+
+    if(output_options.direct_threshold != 0 && hufFile->bit_num >= output_options.direct_threshold){
+        // 很大的输出经对齐缓冲以O_DIRECT写出，不挤占页缓存；映射写入做不到这一点
+        Logger::getInstance().debug("以O_DIRECT写出输出文件，大小 " + std::to_string(hufFile->bit_num));
+        bmp bmpFile;
+        bmpFile.filemap = decodeHuf(hufFile.get(), bitset, hufFile->bitset_size, reference_pointer, dictionary);
+        bmpFile.bit_num = static_cast<u32>(bmpFile.filemap.size());
+        if(!save(output_filename, &bmpFile, output_options)){
+            std::remove(output_filename.c_str());
+            return false;
+        }
+        Logger::getInstance().info("完成HUF到BMP转换任务");
+        return true;
+    }
+
+    // 输出大小就是bitNum：预先设好文件长度并映射，解码结果直接写入输出文件
+    Logger::getInstance().debug("映射输出文件，大小 " + std::to_string(hufFile->bit_num));
+    try{
+        MappedOutputFile output(output_filename, hufFile->bit_num, output_options);
+        decodeHufInto(hufFile.get(), bitset, hufFile->bitset_size, output.data(), reference_pointer, dictionary);
+        if(!output.close()){
+            Logger::getInstance().error("保存BMP文件失败: " + output_filename);
+            std::remove(output_filename.c_str());
+            return false;
+        }
+    }catch(...){
+        // 不留下解了一半的输出文件
+        std::remove(output_filename.c_str());
+        throw;
+    }
+
     Logger::getInstance().info("完成HUF到BMP转换任务");
+    return true;
+}
+
+// 分块读取size字节位集送入计数校验器，不保存解码结果
+template <typename T>
+static bool stream_validate(FileHeadReader &reader, u64 size, node<T> *root, u64 code_num, std::string &error){
+    HuffmanValidator<T> validator(root);
+    std::vector<u8> chunk(64u << 10);
+    while(size > 0){
+        size_t count = reader.readSome(chunk.data(), static_cast<size_t>(std::min<u64>(size, chunk.size())));
+        if(count == 0){
+            error = "bitset truncated";
+            return false;
+        }
+        validator.feed(chunk.data(), count);
+        size -= count;
+    }
+    return validator.finish(code_num, error);
+}
+
+template <typename T>
+static bool stream_validate(FileHeadReader &reader, u64 size, const std::unordered_map<T, u64> &frequency_map, u64 code_num, std::string &error){
+    if(frequency_map.empty()){
+        error = "empty frequency table";
+        return false;
+    }
+    HuffmanTree<T> tree;
+    tree.input_data(frequency_map);
+    tree.spawnTree();
+    return stream_validate(reader, size, tree.get_root(), code_num, error);
+}
+
+bool bmpHandler::validateHuf(const std::string &filename, const std::string &dictionary){
+    Logger::getInstance().info("校验HUF文件: " + filename);
+    std::string error;
+    bool result = false;
+    try{
+        FileHeadReader reader(filename);
+        std::unique_ptr<huf> hufFile(hufHandler::loadHeader(reader));
+        HufCoder coder = static_cast<HufCoder>(hufFile->coder);
+        u64 bitset_size = hufFile->bitset_size;
+
+        if(coder == HufCoder::DELTA){
+            // 跳过参考描述，残差按字节静态哈夫曼校验，不需要参考图像
+            u8 descriptor[Delta::DESCRIPTOR_SIZE];
+            if(bitset_size < Delta::DESCRIPTOR_SIZE || reader.readSome(descriptor, sizeof(descriptor)) != sizeof(descriptor)){
+                throw std::runtime_error("Missing reference descriptor");
+            }
+            bitset_size -= Delta::DESCRIPTOR_SIZE;
+        }
+
+        if((coder == HufCoder::HUFFMAN && hufFile->symbol_bits == 8) || coder == HufCoder::DELTA){
+            std::unordered_map<u8, u64> frequency_map;
+            for(auto &entry : hufFile->key_value_data){
+                frequency_map[static_cast<u8>(entry.first)] = entry.second;
+            }
+            result = stream_validate(reader, bitset_size, frequency_map, hufFile->bit_num, error);
+        }else if(coder == HufCoder::HUFFMAN){
+            if(!SymbolHuffman::validSymbolBits(hufFile->symbol_bits)){
+                throw std::runtime_error("Invalid symbol bits");
+            }
+            std::unordered_map<u16, u64> frequency_map;
+            for(auto &entry : hufFile->key_value_data){
+                if(entry.first >= (1u << hufFile->symbol_bits)){
+                    throw std::runtime_error("Invalid symbol in frequency map");
+                }
+                frequency_map[static_cast<u16>(entry.first)] = entry.second;
+            }
+            // 与解码端一样建表，码长超出查表上限等解码端拒绝的码表在这里同样判为无效
+            SymbolHuffman decoder(hufFile->symbol_bits, hufFile->key_value_data);
+            u64 symbols = (hufFile->bit_num * 8 + hufFile->symbol_bits - 1) / hufFile->symbol_bits;
+            result = stream_validate(reader, bitset_size, frequency_map, symbols, error);
+        }else if(coder == HufCoder::PRETRAINED){
+            std::shared_ptr<const PretrainedTables::Table> table = PretrainedTables::get(hufFile->coder_param, dictionary);
+            result = stream_validate(reader, bitset_size, table->tree->get_root(), hufFile->bit_num, error);
+        }else{
+            Logger::getInstance().debug("该编码后端不支持流式校验，完整解码");
+            hufFile->readBitsetData(reader);
+            result = decodeHuf(hufFile.get(), nullptr, dictionary).size() == hufFile->bit_num;
+            if(!result){
+                error = "decoded size mismatch";
+            }
+        }
+    }catch(const std::exception &e){
+        error = e.what();
+        result = false;
+    }
+
+    if(result){
+        Logger::getInstance().info("校验通过: " + filename);
+    }else{
+        Logger::getInstance().error("校验失败: " + filename + ": " + error);
+    }
     return result;
 }
 
-bool hufHandler::bmp2huf_start(const std::string &filename, const std::string &output_filename, double *process)
-{
-    Logger::getInstance().info("开始BMP到HUF转换任务: " + filename + " -> " + output_filename);
-    Logger::getInstance().debug("加载BMP文件");
-    bmp *bmpFile = bmpHandler::load(filename);
-    
-    Logger::getInstance().debug("创建霍夫曼树");
-    HuffmanTree<u8> tree = HuffmanTree<u8>();
-    
-    Logger::getInstance().debug("输入数据到霍夫曼树");
-    for (u32 num = 0; num < bmpFile->bit_num; num++){
-        tree.input_data(bmpFile->filemap[num]);
+// 分层抽样统计字节频数：把文件等分为若干层，每层取开头的一个64KB块，共约percent%的数据；
+// 所有256个字节值的频数至少为1，抽样中没出现的字节仍有编码。
+// 数据不足MIN_CHUNKS块时完整统计的代价本来就小，返回空表由调用方完整统计
+static std::unordered_map<u8, u64> sampled_frequencies(const u8 *data, u64 size, u8 percent, u64 &sampled){
+    const u64 CHUNK_SIZE = 64u << 10;
+    const u64 MIN_CHUNKS = 64;
+    u64 chunks = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    u64 picks = std::max<u64>(1, chunks * std::min<u8>(percent, 100) / 100);
+    sampled = 0;
+    if(chunks < MIN_CHUNKS || picks * 2 > chunks){
+        return std::unordered_map<u8, u64>();
     }
-    
-    Logger::getInstance().debug("构建霍夫曼树");
+    std::vector<u64> histogram(256, 1);
+    for(u64 p = 0; p < picks; p++){
+        u64 begin = (chunks * p / picks) * CHUNK_SIZE;
+        u64 end = std::min<u64>(begin + CHUNK_SIZE, size);
+        for(u64 i = begin; i < end; i++){
+            histogram[data[i]]++;
+        }
+        sampled += end - begin;
+    }
+    std::unordered_map<u8, u64> frequency_map;
+    for(u32 s = 0; s < 256; s++){
+        frequency_map[static_cast<u8>(s)] = histogram[s];
+    }
+    return frequency_map;
+}
+
+// 按完整直方图建哈夫曼树时位流的字节数，用于衡量抽样建表的压缩率损失
+static u64 full_table_bytes(const std::vector<u64> &histogram){
+    std::unordered_map<u8, u64> frequency_map;
+    for(u32 s = 0; s < 256; s++){
+        if(histogram[s] > 0){
+            frequency_map[static_cast<u8>(s)] = histogram[s];
+        }
+    }
+    if(frequency_map.size() < 2){
+        return 0;
+    }
+    HuffmanTree<u8> tree;
+    tree.input_data(frequency_map);
     tree.spawnTree();
+    u64 bits = 0;
+    for(auto &code : tree.get_code_map()){
+        bits += histogram[code.first] * code.second.second;
+    }
+    return (bits + 7) / 8;
+}
 
-    Logger::getInstance().debug("编码位流数据");
-    std::vector<u8> bitset = BitStream<u8>(tree.get_code_map()).encode(bmpFile->filemap);
+huf *hufHandler::encodeHuf(const std::vector<u8> &data, HufCoder coder, const HufOptions &options)
+{
+    return encodeHuf(data.data(), data.size(), coder, options);
+}
+
+huf *hufHandler::encodeHuf(const u8 *data, u64 size, HufCoder coder, const HufOptions &options)
+{
+    // 各后端直接读取data（可以是映射的文件），输入不复制
+    if(coder == HufCoder::PIXEL && !PixelHuffman::supports(data, size)){
+        Logger::getInstance().info("整像素模式仅支持24/32位图像，改用静态哈夫曼");
+        coder = HufCoder::HUFFMAN;
+    }
 
     Logger::getInstance().debug("创建HUF文件对象");
     huf* hufFile = new huf();
-    hufFile->bit_num = bmpFile->bit_num;
-    hufFile->bitset  = bitset;
-    hufFile->bitset_size = bitset.size();
-    hufFile->key_num = tree.get_code_map().size();
+    hufFile->coder = static_cast<u8>(coder);
+    hufFile->bit_num = size;
     hufFile->key_size = sizeof(unsigned char); // 对于u8类型，key_size总是1
-    hufFile->value_size = tree.get_frequency_length();
+
+    // 静态哈夫曼按像素位深选择符号宽度，其他后端固定按字节编码
+    if(coder == HufCoder::HUFFMAN){
+        hufFile->symbol_bits = options.symbol_bits != 0 ? options.symbol_bits : SymbolHuffman::chooseSymbolBits(data, size);
+    }
+
+    std::vector<u8> bitset;
+    if(hufFile->symbol_bits != 8){
+        Logger::getInstance().debug("构建" + std::to_string(hufFile->symbol_bits) + "位符号码表");
+        SymbolHuffman encoder(data, size, hufFile->symbol_bits);
+
+        Logger::getInstance().debug("编码位流数据");
+        bitset = encoder.encode(data, size);
+
+        hufFile->key_value_data = encoder.get_frequency_map();
+        hufFile->key_num = hufFile->key_value_data.size();
+        hufFile->key_size = encoder.get_key_size();
+        hufFile->value_size = encoder.get_frequency_length();
+    }else if(coder == HufCoder::RICE){
+        // Rice编码逐上下文自适应选择参数，不需要频数表和建树
+        Logger::getInstance().debug("编码Rice位流数据");
+        bitset = RiceCoder().encode(data, size);
+        hufFile->key_num = 0;
+        hufFile->value_size = 1;
+    }else if(coder == HufCoder::SEGMENTED){
+        // 一张码表，文件头单独一段，像素数据按整行切成约64KB的段，便于之后在压缩数据上裁剪和切分
+        const u64 SEGMENT_TARGET = 64u << 10;
+        std::vector<u64> histogram(256, 0);
+        for(u64 i = 0; i < size; i++){
+            histogram[data[i]]++;
+        }
+        SegmentedHuffman encoder(std::vector<std::vector<u64>>(1, histogram));
+        BmpLayout layout = BmpLayout::parse(data, size);
+        u64 first = layout.valid() ? layout.offset : 0;
+        u64 step = layout.valid() ? std::max<u64>(1, SEGMENT_TARGET / layout.row_bytes) * layout.row_bytes : SEGMENT_TARGET;
+
+        Logger::getInstance().debug("编码分段位流数据");
+        std::vector<SegmentedHuffman::Segment> segments;
+        // 段目录每段至多21字节，一并预留，拼接目录时不需要重新分配
+        std::vector<u8> payload;
+        payload.reserve(encode_reserve(size) + (size / step + 2) * 21 + 4);
+        if(first > 0){
+            segments.push_back(encoder.encodeSegment(data, first, 0, payload));
+        }
+        for(u64 offset = first; offset < size; offset += step){
+            segments.push_back(encoder.encodeSegment(data + offset, std::min<u64>(step, size - offset), 0, payload));
+        }
+        bitset = SegmentedHuffman::assemble(segments, std::move(payload));
+        hufFile->coder_param = 1;
+        hufFile->key_size = 2;
+        hufFile->key_value_data = encoder.get_frequency_map();
+        hufFile->key_num = hufFile->key_value_data.size();
+        hufFile->value_size = encoder.get_frequency_length();
+    }else if(coder == HufCoder::STORED){
+        bitset.assign(data, data + size);
+        hufFile->key_num = 0;
+        hufFile->value_size = 1;
+    }else if(coder == HufCoder::PIXEL){
+        Logger::getInstance().debug("统计高频像素并构建整像素码表");
+        PixelHuffman encoder(data, size);
+
+        Logger::getInstance().debug("编码整像素位流数据");
+        bitset = encoder.encode(data, size);
+
+        hufFile->key_value_data = encoder.get_frequency_map();
+        hufFile->key_num = hufFile->key_value_data.size();
+        hufFile->key_size = encoder.get_key_size();
+        hufFile->value_size = encoder.get_frequency_length();
+    }else if(coder == HufCoder::BLOCK){
+        // 按统计变化切分块，各块从少量共享码表中选择
+        Logger::getInstance().debug("分析块边界并聚类码表");
+        BlockHuffman encoder(data, size);
+        hufFile->coder_param = static_cast<u8>(encoder.get_table_count());
+        hufFile->key_size = 2;
+
+        Logger::getInstance().debug("编码分块位流数据");
+        bitset = encoder.encode(data, size);
+
+        hufFile->key_value_data = encoder.get_frequency_map();
+        hufFile->key_num = hufFile->key_value_data.size();
+        hufFile->value_size = encoder.get_frequency_length();
+    }else if(coder == HufCoder::PRETRAINED){
+        // 指定编号时单遍编码，既不统计频数也不保存码表
+        u8 table_id = options.table_id != PretrainedTables::AUTO_ID ? options.table_id : PretrainedTables::choose(data, size, options.dictionary);
+        std::shared_ptr<const PretrainedTables::Table> table = PretrainedTables::get(table_id, options.dictionary);
+        hufFile->coder_param = table_id;
+
+        Logger::getInstance().debug("用预训练码表 " + std::to_string(table_id) + " 编码位流数据");
+        bitset = PretrainedTables::encode(*table, data, size);
+        hufFile->key_num = 0;
+        hufFile->value_size = 1;
+    }else if(coder == HufCoder::CONTEXT){
+        // 每个上下文一张码表，键的高位为上下文编号
+        Logger::getInstance().debug("构建上下文码表");
+        ContextHuffman encoder(data, size);
+        hufFile->coder_param = encoder.get_context_bits();
+        hufFile->key_size = 2;
+
+        Logger::getInstance().debug("编码上下文位流数据");
+        bitset = encoder.encode(data, size);
+
+        hufFile->key_value_data = encoder.get_frequency_map();
+        hufFile->key_num = hufFile->key_value_data.size();
+        hufFile->value_size = encoder.get_frequency_length();
+    }else{
+        Logger::getInstance().debug("创建霍夫曼树");
+        HuffmanTree<u8> tree = HuffmanTree<u8>();
+
+        u64 sampled = 0;
+        std::unordered_map<u8, u64> sample_map;
+        if(options.sample_percent != 0){
+            sample_map = sampled_frequencies(data, size, options.sample_percent, sampled);
+        }
+        if(!sample_map.empty()){
+            Logger::getInstance().debug("按 " + std::to_string(options.sample_percent) + "% 抽样统计频数");
+            tree.input_data(sample_map);
+        }else{
+            Logger::getInstance().debug("输入数据到霍夫曼树");
+            std::vector<u64> histogram(256, 0);
+            for(u64 i = 0; i < size; i++){
+                histogram[data[i]]++;
+            }
+            std::unordered_map<u8, u64> frequency_map;
+            for(u32 s = 0; s < 256; s++){
+                if(histogram[s] > 0){
+                    frequency_map[static_cast<u8>(s)] = histogram[s];
+                }
+            }
+            tree.input_data(frequency_map);
+        }
+
+        Logger::getInstance().debug("构建霍夫曼树");
+        tree.spawnTree();
+
+        if(coder == HufCoder::TANS){
+            // tANS与哈夫曼共用同一份频数表，解码端据此重建相同的归一化表
+            Logger::getInstance().debug("构建tANS编码表");
+            TansCoder encoder(tree.get_frequency_map());
+            hufFile->coder_param = encoder.get_table_log();
+
+            Logger::getInstance().debug("编码tANS位流数据");
+            bitset = encoder.encode(data, size);
+        }else if(!sample_map.empty()){
+            // 编码时顺带统计完整直方图，不增加额外的遍历，用来报告与完整建表相比的损失
+            Logger::getInstance().debug("编码位流数据");
+            std::vector<std::pair<u64, u8>> codes(256);
+            for(auto &code : tree.get_code_map()){
+                codes[code.first] = code.second;
+            }
+            std::vector<u64> histogram(256, 0);
+            BitWriter writer;
+            writer.reserve(encode_reserve(size));
+            for(u64 i = 0; i < size; i++){
+                histogram[data[i]]++;
+                writer.put(codes[data[i]].first, codes[data[i]].second);
+            }
+            bitset = writer.finish();
+
+            u64 full = full_table_bytes(histogram);
+            Logger::getInstance().info("抽样建表: 抽样 " + std::to_string(sampled) + "/" + std::to_string(size) +
+                                       " 字节, 位流 " + std::to_string(bitset.size()) + " 字节, 完整建表为 " +
+                                       std::to_string(full) + " 字节, 损失 " +
+                                       std::to_string((static_cast<double>(bitset.size()) / std::max<u64>(full, 1) - 1) * 100) + "%");
+        }else{
+            Logger::getInstance().debug("编码位流数据");
+            std::vector<std::pair<u64, u8>> codes(256);
+            for(auto &code : tree.get_code_map()){
+                codes[code.first] = code.second;
+            }
+            // 频数是完整统计的，位流长度可以准确算出，只分配一次
+            u64 bits = 0;
+            for(auto &entry : tree.get_frequency_map()){
+                bits += entry.second * codes[entry.first].second;
+            }
+            BitWriter writer;
+            writer.reserve(static_cast<size_t>(bits / 8 + 1));
+            for(u64 i = 0; i < size; i++){
+                writer.put(codes[data[i]].first, codes[data[i]].second);
+            }
+            bitset = writer.finish();
+        }
+
+        hufFile->key_num = tree.get_code_map().size();
+        hufFile->value_size = tree.get_frequency_length();
+
+        Logger::getInstance().debug("转换键值对数据格式");
+        std::unordered_map<u64,u64> key_value_data;
+        for(auto i :tree.get_frequency_map()){
+            key_value_data.insert(std::make_pair(static_cast<u64>(i.first),i.second));
+        }
+        hufFile->key_value_data = key_value_data;
+    }
+
+    hufFile->bitset_size = bitset.size();
+    hufFile->bitset = std::move(bitset);
+    return hufFile;
+}
+
+// 各压缩级别的候选后端，级别越高候选越多、越慢
+static std::vector<HufCoder> level_candidates(u8 level){
+    switch(level){
+        case 1: return {HufCoder::STORED};
+        case 2: return {HufCoder::PRETRAINED};
+        case 3: return {HufCoder::HUFFMAN};
+        case 4: return {HufCoder::HUFFMAN, HufCoder::TANS};
+        case 5: return {HufCoder::HUFFMAN, HufCoder::TANS, HufCoder::RICE, HufCoder::PIXEL};
+        case 6: return {HufCoder::HUFFMAN, HufCoder::TANS, HufCoder::RICE, HufCoder::PIXEL, HufCoder::CONTEXT};
+        default: return {HufCoder::HUFFMAN, HufCoder::TANS, HufCoder::RICE, HufCoder::PIXEL, HufCoder::CONTEXT, HufCoder::BLOCK};
+    }
+}
+
+// 试编码使用的抽样大小，0为整个文件
+static u64 sample_budget(u8 level){
+    if(level >= 9){
+        return 0;
+    }
+    return level == 8 ? (1u << 20) : (256u << 10);
+}
+
+static void write_le32(u8 *p, u32 value){
+    for(int b = 0; b < 4; b++){
+        p[b] = static_cast<u8>(value >> (8 * b));
+    }
+}
+
+// 抽取若干条等距的整行带拼成一个较小的BMP，文件头中的高度和大小同步修改，
+// 使依赖图像结构的后端在抽样上的表现与整个文件一致；scale为原始像素数据与抽样像素数据的比
+static std::vector<u8> build_sample(const u8 *data, u64 size, u64 budget, double &scale){
+    const u64 BANDS = 4;
+    scale = 1;
+    if(budget == 0 || size <= budget){
+        return std::vector<u8>(data, data + size);
+    }
+    BmpLayout layout = BmpLayout::parse(data, size);
+    if(!layout.valid()){
+        scale = static_cast<double>(size) / budget;
+        return std::vector<u8>(data, data + budget);
+    }
+    u64 rows = static_cast<u64>(layout.height < 0 ? -static_cast<long long>(layout.height) : layout.height);
+    rows = std::min<u64>(rows, (size - layout.offset) / layout.row_bytes);
+    u64 sample_rows = budget > layout.offset ? (budget - layout.offset) / layout.row_bytes : 0;
+    if(sample_rows == 0 || sample_rows >= rows){
+        return std::vector<u8>(data, data + size);
+    }
+    u64 band_rows = std::max<u64>(1, sample_rows / BANDS);
+    u64 bands = sample_rows / band_rows;
+
+    std::vector<u8> sample(data, data + layout.offset);
+    for(u64 b = 0; b < bands; b++){
+        u64 first_row = bands > 1 ? (rows - band_rows) * b / (bands - 1) : 0;
+        const u8 *begin = data + layout.offset + first_row * layout.row_bytes;
+        sample.insert(sample.end(), begin, begin + band_rows * layout.row_bytes);
+    }
+    u64 taken = bands * band_rows;
+    write_le32(sample.data() + 2, static_cast<u32>(sample.size()));
+    write_le32(sample.data() + 22, static_cast<u32>(layout.height < 0 ? -static_cast<long long>(taken) : static_cast<long long>(taken)));
+    write_le32(sample.data() + 34, static_cast<u32>(taken * layout.row_bytes));
+    scale = static_cast<double>(size - layout.offset) / (sample.size() - layout.offset);
+    return sample;
+}
+
+HufCoder hufHandler::chooseCoder(const std::vector<u8> &data, const HufOptions &options)
+{
+    return chooseCoder(data.data(), data.size(), options);
+}
+
+HufCoder hufHandler::chooseCoder(const u8 *data, u64 size, const HufOptions &options)
+{
+    u8 level = std::min(options.level, MAX_LEVEL);
+    std::vector<HufCoder> candidates = level_candidates(level);
+    if(candidates.size() == 1){
+        return candidates.front();
+    }
+
+    double scale = 1;
+    std::vector<u8> sample = build_sample(data, size, sample_budget(level), scale);
+    Logger::getInstance().debug("按级别 " + std::to_string(level) + " 在 " + std::to_string(sample.size()) + " 字节的抽样上选择后端");
+
+    struct Estimate
+    {
+        HufCoder coder;
+        double size;
+        double milliseconds;
+    };
+    std::vector<Estimate> estimates;
+    for(HufCoder candidate : candidates){
+        try{
+            auto start = std::chrono::steady_clock::now();
+            huf *hufFile = encodeHuf(sample, candidate, options);
+            double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            // 码表大小与数据量基本无关，只按比例放大位集
+            double size = static_cast<double>(fileSize(hufFile) - hufFile->bitset_size) + hufFile->bitset_size * scale;
+            estimates.push_back(Estimate{candidate, size, elapsed * scale});
+            Logger::getInstance().debug("候选后端 " + std::to_string(static_cast<int>(candidate)) + " 估算 " +
+                                        std::to_string(static_cast<u64>(size)) + " 字节, " + std::to_string(elapsed * scale) + " ms");
+            delete hufFile;
+        }catch(const std::exception &e){
+            Logger::getInstance().debug("候选后端 " + std::to_string(static_cast<int>(candidate)) + " 不适用: " + e.what());
+        }
+    }
+    if(estimates.empty()){
+        return HufCoder::HUFFMAN;
+    }
+
+    double smallest = estimates.front().size;
+    for(const Estimate &estimate : estimates){
+        smallest = std::min(smallest, estimate.size);
+    }
+    double tolerance = options.target == HufTarget::SPEED ? 1.10 : (options.target == HufTarget::BALANCED ? 1.03 : 1.0);
+    const Estimate *best = nullptr;
+    for(const Estimate &estimate : estimates){
+        if(estimate.size > smallest * tolerance){
+            continue;
+        }
+        if(best == nullptr || (tolerance > 1.0 ? estimate.milliseconds < best->milliseconds : estimate.size < best->size)){
+            best = &estimate;
+        }
+    }
+    Logger::getInstance().info("选择编码后端 " + std::to_string(static_cast<int>(best->coder)) + "，估算 " + std::to_string(static_cast<u64>(best->size)) + " 字节");
+    return best->coder;
+}
+
+// 字节直方图，数据较大时分段由多个线程各自统计再合并
+static std::vector<u64> parallel_histogram(const u8 *data, u64 size){
+    const u64 MIN_PART_SIZE = 4u << 20;
+    u64 parts = std::min<u64>(std::max(1u, std::thread::hardware_concurrency()), size / MIN_PART_SIZE);
+    parts = std::max<u64>(parts, 1);
+    std::vector<std::vector<u64>> partial(parts, std::vector<u64>(256, 0));
+    auto count = [data, size, &partial, parts](u64 part){
+        u64 begin = size * part / parts;
+        u64 end = size * (part + 1) / parts;
+        std::vector<u64> &histogram = partial[part];
+        for(u64 i = begin; i < end; i++){
+            histogram[data[i]]++;
+        }
+    };
+    std::vector<std::thread> workers;
+    for(u64 part = 1; part < parts; part++){
+        workers.emplace_back(count, part);
+    }
+    count(0);
+    for(std::thread &worker : workers){
+        worker.join();
+    }
+    for(u64 part = 1; part < parts; part++){
+        for(u32 s = 0; s < 256; s++){
+            partial[0][s] += partial[part][s];
+        }
+    }
+    return partial[0];
+}
+
+template <typename K>
+static double shannon_bytes(const std::unordered_map<K, u64> &frequency_map){
+    double total = 0;
+    for(const auto &entry : frequency_map){
+        total += entry.second;
+    }
+    double bits = 0;
+    for(const auto &entry : frequency_map){
+        bits += entry.second * std::log2(total / entry.second);
+    }
+    return bits / 8;
+}
+
+HufEstimate hufHandler::estimate(const std::string &filename, const HufOptions &options)
+{
+    Logger::getInstance().info("预估压缩大小: " + filename);
+    // 直接在映射上统计，不把整个文件读进内存
+    MappedFile input(filename, options.map_populate);
+    const u8 *data = input.data();
+    u64 size = input.size();
+
+    HufEstimate result;
+    result.original_size = size;
+    result.symbol_bits = options.symbol_bits != 0 ? options.symbol_bits : SymbolHuffman::chooseSymbolBits(data, size);
+
+    huf hufFile;
+    if(result.symbol_bits != 8){
+        SymbolHuffman encoder(data, size, result.symbol_bits);
+        std::unordered_map<u64, u64> frequency_map = encoder.get_frequency_map();
+        hufFile.key_size = encoder.get_key_size();
+        hufFile.value_size = encoder.get_frequency_length();
+        hufFile.key_num = frequency_map.size();
+        hufFile.bitset_size = (encoder.get_encoded_bits() + 7) / 8;
+        result.entropy_size = shannon_bytes(frequency_map);
+    }else{
+        std::vector<u64> histogram = parallel_histogram(data, size);
+        std::unordered_map<u8, u64> frequency_map;
+        for(u32 s = 0; s < 256; s++){
+            if(histogram[s] > 0){
+                frequency_map[static_cast<u8>(s)] = histogram[s];
+            }
+        }
+        HuffmanTree<u8> tree;
+        tree.input_data(frequency_map);
+        tree.spawnTree();
+        u64 bits = 0;
+        for(auto &code : tree.get_code_map()){
+            bits += histogram[code.first] * code.second.second;
+        }
+        hufFile.key_size = 1;
+        hufFile.value_size = tree.get_frequency_length();
+        hufFile.key_num = frequency_map.size();
+        hufFile.bitset_size = (bits + 7) / 8;
+        result.entropy_size = shannon_bytes(frequency_map);
+    }
+    result.compressed_size = fileSize(&hufFile);
+
+    Logger::getInstance().info("预估结果: " + std::to_string(result.original_size) + " -> " + std::to_string(result.compressed_size) +
+                               " 字节, 熵下界 " + std::to_string(static_cast<u64>(result.entropy_size)) + " 字节");
+    return result;
+}
+
+huf *hufHandler::compress(const u8 *data, u64 size, const HufOptions &options)
+{
+    HufCoder coder = options.coder;
+    if(options.level != 0){
+        coder = chooseCoder(data, size, options);
+    }
+
+    huf *hufFile = encodeHuf(data, size, coder, options);
+    if(options.level != 0){
+        // 压缩后反而比原始数据大时直接存储
+        if(coder != HufCoder::STORED && fileSize(hufFile) > sizeof(HufHeader) + size){
+            Logger::getInstance().info("压缩结果大于原始数据，改为直接存储");
+            delete hufFile;
+            hufFile = encodeHuf(data, size, HufCoder::STORED, options);
+        }
+        hufFile->level = std::min(options.level, MAX_LEVEL);
+    }
+    return hufFile;
+}
+
+huf *hufHandler::compressDelta(std::vector<u8> &data, const std::vector<u8> &reference, const HufOptions &options)
+{
+    // 与参考图像逐字节求差，残差交给按字节的静态哈夫曼
+    std::vector<u8> reference_descriptor(Delta::DESCRIPTOR_SIZE);
+    Delta::writeDescriptor(reference_descriptor.data(), Delta::fingerprint(reference.data(), reference.size()), reference.size());
+
+    Logger::getInstance().debug("计算与参考图像的残差");
+    u64 overlap = std::min<u64>(data.size(), reference.size());
+    Delta::subtract(data.data(), data.data(), reference.data(), overlap);
+
+    huf *hufFile = encodeHuf(data, HufCoder::DELTA, options);
+    if(options.level != 0){
+        hufFile->level = std::min(options.level, MAX_LEVEL);
+    }
+    CopyCounter::add(hufFile->bitset.size() + reference_descriptor.size());
+    hufFile->bitset.insert(hufFile->bitset.begin(), reference_descriptor.begin(), reference_descriptor.end());
+    hufFile->bitset_size = hufFile->bitset.size();
+    return hufFile;
+}
+
+bool hufHandler::bmp2huf_start(const std::string &filename, const std::string &output_filename, double *process,
+                               const HufOptions &options)
+{
+    if(options.coder == HufCoder::ADAPTIVE){
+        return bmp2huf_stream(filename, output_filename, process, options.output);
+    }
+
+    Logger::getInstance().info("开始BMP到HUF转换任务: " + filename + " -> " + output_filename);
+    // 差分编码要在原始数据上就地求残差，需要可写的副本；其他情况直接在映射上编码
+    std::unique_ptr<MappedFile> mapping;
+    std::unique_ptr<bmp> bmpFile;
+    const u8 *data = nullptr;
+    u64 size = 0;
+    if(options.reference.empty() && options.memory_map){
+        Logger::getInstance().debug("映射BMP文件");
+        mapping.reset(new MappedFile(filename, options.map_populate));
+        data = mapping->data();
+        size = mapping->size();
+    }else{
+        Logger::getInstance().debug("加载BMP文件");
+        bmpFile.reset(bmpHandler::load(filename));
+        data = bmpFile->filemap.data();
+        size = bmpFile->filemap.size();
+    }
     
-    Logger::getInstance().debug("转换键值对数据格式");
-    std::unordered_map<u64,u64> key_value_data;
-    for(auto i :tree.get_frequency_map()){
-        key_value_data.insert(std::make_pair(static_cast<u64>(i.first),i.second));
+    huf *hufFile = nullptr;
+    if(!options.reference.empty()){
+        hufFile = compressDelta(bmpFile->filemap, bmpHandler::loadReference(options.reference, options.dictionary), options);
+    }else{
+        hufFile = compress(data, size, options);
     }
-    hufFile->key_value_data = key_value_data;
 
     Logger::getInstance().debug("保存HUF文件");
-    hufHandler::save(output_filename, hufFile);
+    bool result = hufHandler::save(output_filename, hufFile, options.output);
     
-    delete bmpFile;
     delete hufFile;
     
     Logger::getInstance().info("完成BMP到HUF转换任务");
-    return true;
-}
\ No newline at end of file
+    return result;
+}
+
+bool hufHandler::bmp2huf_stream(const std::string &filename, const std::string &output_filename, double *process,
+                                const WriteOptions &output)
+{
+    Logger::getInstance().info("开始流式BMP到HUF转换任务: " + filename + " -> " + output_filename);
+    FileReader reader(filename);
+    FileWriter writer(output_filename, output);
+
+    huf hufFile;
+    hufFile.coder = static_cast<u8>(HufCoder::ADAPTIVE);
+    hufFile.coder_param = 16;
+    hufFile.key_size = sizeof(unsigned char);
+    hufFile.value_size = 1;
+    hufFile.key_num = 0;
+    hufFile.bit_num = 0;
+    hufFile.bitset_size = 0;
+
+    // 先写占位文件头，数据量在读完输入后才知道
+    writeHeader(writer, &hufFile, 0);
+
+    // 单遍编码事先不读完输入，进度按已读入的字节占文件大小的比例计算
+    const u64 input_size = reader.getFile().getFileSize();
+    auto report = [&](){
+        if(process){
+            *process = input_size > 0 ? std::min(1.0, static_cast<double>(hufFile.bit_num) / input_size) : 1.0;
+        }
+    };
+
+    AdaptiveHuffman encoder;
+    BitWriter bits;
+    std::vector<u8> block;
+    auto flush = [&](const std::vector<u8> &bytes){
+        writer.writeBlock(bytes.data(), bytes.size());
+        hufFile.bitset_size += bytes.size();
+    };
+
+    while(true){
+        // 块边界必须与解码端一致，因此每次尽量读满一个块
+        block.resize(encoder.nextBlockSize());
+        size_t filled = 0;
+        while(filled < block.size()){
+            size_t count = reader.readSome(block.data() + filled, block.size() - filled);
+            if(count == 0){
+                break;
+            }
+            filled += count;
+        }
+        if(filled == 0){
+            break;
+        }
+        encoder.encodeBlock(block.data(), filled, bits);
+        hufFile.bit_num += filled;
+        flush(bits.takeBytes());
+        report();
+        if(filled < block.size()){
+            break;
+        }
+    }
+    flush(bits.finish());
+    report();
+    Logger::getInstance().debug("流式编码完成，输入 " + std::to_string(hufFile.bit_num) +
+                                " 字节，位集 " + std::to_string(hufFile.bitset_size) + " 字节");
+
+    writer.seek(0);
+    writeHeader(writer, &hufFile, static_cast<u32>(sizeof(HufHeader) + hufFile.bitset_size));
+    bool result = writer.close();
+
+    Logger::getInstance().info("完成流式BMP到HUF转换任务");
+    return result;
+}
@@ -0,0 +1,212 @@
+#include "batchConvert.h"
+#include "bmpHandler.h"
+#include "submit_convertTask.h"
+#include "../FileTaskPool/ioEngine.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+typedef std::function<std::vector<u8>(std::vector<u8> &input)> Converter;
+
+// 同时驻留内存的文件数：每个线程一个正在编解码，另一个已读入等待
+size_t window_size(){
+    return std::max<size_t>(2, gPool().thread_count() * 2);
+}
+
+void check_paths(const std::vector<std::string> &inputs, const std::vector<std::string> &outputs){
+    if(inputs.size() != outputs.size()){
+        Logger::getInstance().error("输入和输出文件数量不一致");
+        throw std::invalid_argument("Input and output counts differ");
+    }
+}
+
+// 读入 -> 线程池转换 -> 写出，最多window个文件同时在途，读写完成后立即开始下一个文件。
+// 开始读一个文件时预读其后depth个将要读的输入，读入内存后即丢弃它的页缓存
+std::vector<bool> run_batch(const std::vector<std::string> &inputs, const std::vector<std::string> &outputs,
+                            double *progress, const WriteOptions &output, const Converter &convert){
+    size_t count = inputs.size();
+    std::vector<char> succeeded(count, 0);
+    std::mutex mtx;
+    std::condition_variable done_cv;
+    size_t next = 0;
+    size_t finished = 0;
+    size_t window = std::min(window_size(), count);
+    size_t advised = window; // 窗口内的文件立即读取，预读从窗口之后开始
+    const PrefetchOptions prefetch = gPrefetcher().options();
+    std::function<void()> start_next;
+
+    auto finish = [&](size_t index, bool ok){
+        if(!ok){
+            Logger::getInstance().error("批量转换失败: " + inputs[index]);
+        }
+        bool more = false;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            succeeded[index] = ok;
+            finished++;
+            if(progress){
+                *progress = static_cast<double>(finished) / count;
+            }
+            more = next < count;
+            done_cv.notify_all();
+        }
+        if(more){
+            start_next();
+        }
+    };
+
+    // 最后构造、最先析构：析构时等待所有回调结束，回调中引用的局部变量仍然有效
+    IoEngine engine(32, true, output);
+    Logger::getInstance().info(std::string("批量转换 ") + std::to_string(count) + " 个文件，" +
+                               (engine.usingUring() ? "io_uring" : "I/O线程") + "异步读写");
+
+    start_next = [&](){
+        size_t index;
+        size_t advise_from;
+        size_t advise_to;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            if(next >= count){
+                return;
+            }
+            index = next++;
+            advise_from = std::max(advised, next);
+            advise_to = std::min(count, next + prefetch.depth);
+            advised = std::max(advised, advise_to);
+        }
+        for(size_t i = advise_from; i < advise_to; i++){
+            gPrefetcher().willNeed(inputs[i]);
+        }
+        engine.read(inputs[index], [&, index](std::vector<u8> &&data, const std::string &error){
+            if(!error.empty()){
+                Logger::getInstance().error("读取失败: " + inputs[index] + " (" + error + ")");
+                finish(index, false);
+                return;
+            }
+            if(prefetch.drop_processed){
+                gPrefetcher().dontNeed(inputs[index]);
+            }
+            std::shared_ptr<std::vector<u8>> input = std::make_shared<std::vector<u8>>(std::move(data));
+            try{
+                gPool().submit([&, index, input](){
+                    std::vector<u8> converted;
+                    try{
+                        converted = convert(*input);
+                    }catch(const std::exception &e){
+                        Logger::getInstance().error("转换失败: " + inputs[index] + " (" + e.what() + ")");
+                        finish(index, false);
+                        return;
+                    }
+                    // 输入在写出前释放
+                    input->clear();
+                    input->shrink_to_fit();
+                    engine.write(outputs[index], std::move(converted), [&, index](bool ok){
+                        finish(index, ok);
+                    });
+                });
+            }catch(const std::exception &e){
+                Logger::getInstance().error(std::string("提交转换任务失败: ") + e.what());
+                finish(index, false);
+            }
+        });
+    };
+
+    for(size_t i = 0; i < window; i++){
+        start_next();
+    }
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        done_cv.wait(lock, [&]{ return finished == count; });
+    }
+    engine.wait();
+    return std::vector<bool>(succeeded.begin(), succeeded.end());
+}
+
+// 批量持久化：整批写完后统一等待落盘，同步失败的文件记为失败
+void sync_batch(const std::vector<std::string> &outputs, const WriteOptions &output, std::vector<bool> &succeeded){
+    if(output.durability != Durability::BATCH){
+        return;
+    }
+    for(const std::string &failed : FileWriter::syncDeferred()){
+        Logger::getInstance().error("同步到磁盘失败: " + failed);
+        for(size_t i = 0; i < outputs.size(); i++){
+            if(outputs[i] == failed){
+                succeeded[i] = false;
+            }
+        }
+    }
+}
+
+}
+
+std::vector<bool> batchConvert::bmp2huf(const std::vector<std::string> &inputs, const std::vector<std::string> &outputs,
+                                        double *progress, const HufOptions &options){
+    check_paths(inputs, outputs);
+    if(options.coder == HufCoder::ADAPTIVE){
+        Logger::getInstance().info("自适应编码为流式处理，逐个文件同步读写");
+        std::vector<bool> succeeded;
+        std::deque<std::future<bool>> running;
+        auto collect = [&](){
+            try{
+                succeeded.push_back(running.front().get());
+            }catch(const std::exception &e){
+                Logger::getInstance().error(std::string("批量转换失败: ") + e.what());
+                succeeded.push_back(false);
+            }
+            running.pop_front();
+            if(progress){
+                *progress = static_cast<double>(succeeded.size()) / inputs.size();
+            }
+        };
+        for(size_t i = 0; i < inputs.size(); i++){
+            if(running.size() >= window_size()){
+                collect();
+            }
+            std::string input = inputs[i];
+            std::string output = outputs[i];
+            WriteOptions write_options = options.output;
+            running.push_back(gPool().submit_with_result([input, output, write_options](){
+                return hufHandler::bmp2huf_stream(input, output, nullptr, write_options);
+            }));
+        }
+        while(!running.empty()){
+            collect();
+        }
+        sync_batch(outputs, options.output, succeeded);
+        return succeeded;
+    }
+
+    // 所有文件共用同一份参考图像
+    std::shared_ptr<const std::vector<u8>> reference;
+    if(!options.reference.empty()){
+        reference = std::make_shared<const std::vector<u8>>(bmpHandler::loadReference(options.reference, options.dictionary));
+    }
+    std::vector<bool> succeeded = run_batch(inputs, outputs, progress, options.output, [&options, reference](std::vector<u8> &input){
+        std::unique_ptr<huf> hufFile(reference ? hufHandler::compressDelta(input, *reference, options)
+                                               : hufHandler::compress(input.data(), input.size(), options));
+        return hufHandler::serialize(hufFile.get());
+    });
+    sync_batch(outputs, options.output, succeeded);
+    return succeeded;
+}
+
+std::vector<bool> batchConvert::huf2bmp(const std::vector<std::string> &inputs, const std::vector<std::string> &outputs,
+                                        double *progress, const std::string &reference, const std::string &dictionary,
+                                        const WriteOptions &output){
+    check_paths(inputs, outputs);
+    std::shared_ptr<const std::vector<u8>> reference_data;
+    if(!reference.empty()){
+        reference_data = std::make_shared<const std::vector<u8>>(bmpHandler::loadReference(reference, dictionary));
+    }
+    std::vector<bool> succeeded = run_batch(inputs, outputs, progress, output, [&dictionary, reference_data](std::vector<u8> &input){
+        u64 bitset_offset = 0;
+        std::unique_ptr<huf> hufFile(hufHandler::parse(input.data(), input.size(), bitset_offset));
+        return bmpHandler::decodeHuf(hufFile.get(), input.data() + bitset_offset, hufFile->bitset_size,
+                                     reference_data.get(), dictionary);
+    });
+    sync_batch(outputs, output, succeeded);
+    return succeeded;
+}
@@ -0,0 +1,26 @@
+#ifndef BATCH_CONVERT_H
+#define BATCH_CONVERT_H
+
+#include "hufHandler.h"
+#include <string>
+#include <vector>
+
+// 批量转换：输入和输出由IoEngine异步读写（Linux上为io_uring），全局线程池只做编解码，
+// 一个文件在编码时其他文件的读写同时进行。同时驻留内存的文件数不超过线程池线程数的两倍。
+// 写出按WriteOptions预分配和持久化，Durability::BATCH时整批写完后统一等待落盘。
+// 返回每个文件是否成功，progress为已完成文件的比例
+class batchConvert
+{
+public:
+    // 自适应编码是流式的，仍由线程池逐个文件同步读写
+    static std::vector<bool> bmp2huf(const std::vector<std::string> &inputs, const std::vector<std::string> &outputs,
+                                     double *progress, const HufOptions &options = HufOptions());
+
+    // 差分文件需提供参考图像，使用字典码表的文件需提供字典
+    static std::vector<bool> huf2bmp(const std::vector<std::string> &inputs, const std::vector<std::string> &outputs,
+                                     double *progress, const std::string &reference = std::string(),
+                                     const std::string &dictionary = std::string(),
+                                     const WriteOptions &output = WriteOptions());
+};
+
+#endif // BATCH_CONVERT_H
@@ -6,6 +6,9 @@
 #include "../FileStream/FileFormat.h"
 #include "../logger/Logger.h"
 #include <unordered_map>
+#include <vector>
+
+class huf;
 
 
 // 使用与FileFormat.h中一致的bit定义
@@ -37,19 +40,14 @@ public:
       filemap.resize(bit_num);
       
       // 重置文件指针到开始位置
-      reader.getFile().getInputStream().seekg(0, std::ios::beg);
-      
-      for(u32 i = 0; i < bit_num; i++){
-        filemap[i] = reader.readu8();
-      }
+      reader.seek(0);
+      reader.readBlock(filemap.data(), bit_num);
       Logger::getInstance().info("成功读取BMP位图数据");
     }
 
     void writeData(FileWriter &writer) const override{
       Logger::getInstance().info("开始写入BMP数据");
-      for(u32 i = 0; i < bit_num; i++){
-        writer.writeu8(filemap[i]);
-      }
+      writer.writeBlock(filemap.data(), bit_num);
       Logger::getInstance().info("成功写入BMP数据");
     }
 };
@@ -58,7 +56,29 @@ class bmpHandler
 {
 
 public:
-  static bool huf2bmp_start(const std::string &filename, const std::string &output_filename, double *process); // 图像处理任务（加载huf文件，构造huf文件体，读取数据-频数对构造huffman树，还原位流，保存bmp文件）
+  static bool huf2bmp_start(const std::string &filename, const std::string &output_filename, double *process,
+                            const std::string &reference = std::string(),
+                            const std::string &dictionary = std::string(),
+                            const WriteOptions &output = WriteOptions()); // 图像处理任务（加载huf文件，构造huf文件体，读取数据-频数对构造huffman树，还原位流，保存bmp文件）；差分文件需提供参考图像，使用字典码表的文件需提供字典
+
+  // 按文件头记录的编码后端还原出原始字节，差分文件需传入参考图像数据
+  static std::vector<u8> decodeHuf(const huf *hufFile, const std::vector<u8> *reference, const std::string &dictionary = std::string());
+
+  // 同上，位集不在hufFile->bitset中而在给定的内存里（如映射的文件）
+  static std::vector<u8> decodeHuf(const huf *hufFile, const u8 *bitset, u64 bitset_size, const std::vector<u8> *reference,
+                                   const std::string &dictionary = std::string());
+
+  // 解码到调用者提供的bitNum字节内存（如映射的输出文件），所有后端都直接写入out，不经过中间缓冲
+  static void decodeHufInto(const huf *hufFile, const u8 *bitset, u64 bitset_size, u8 *out, const std::vector<u8> *reference,
+                            const std::string &dictionary = std::string());
+
+  // 只校验不输出：检查位集恰好解出bitNum个符号、没有无效码路径、末尾填充位为0。
+  // 静态哈夫曼（含差分残差）和预训练码表的文件流式计数校验，内存占用与文件大小无关；
+  // 其他后端完整解码到内存后检查长度
+  static bool validateHuf(const std::string &filename, const std::string &dictionary = std::string());
+
+  // 读取参考图像的原始字节，可以是.bmp或非差分的.huf
+  static std::vector<u8> loadReference(const std::string &filename, const std::string &dictionary = std::string());
 
   static bmp *load(const std::string &filename) {
     Logger::getInstance().info("正在加载BMP文件: " + filename);
@@ -71,9 +91,9 @@ public:
   }
 
   // 保存bmp文件（读取bmpFile，保存到filename中
-  static bool save(const std::string &filename, const bmp *bmpFile){
+  static bool save(const std::string &filename, const bmp *bmpFile, const WriteOptions &options = WriteOptions()){
     Logger::getInstance().info("正在保存BMP文件: " + filename);
-    FileWriter writer(filename);
+    FileWriter writer(filename, options, bmpFile->bit_num);
     bmpFile->writeData(writer);
     bool result = writer.close();
     if (result) {
@@ -0,0 +1,330 @@
+#include "hufEdit.h"
+#include "bmpHandler.h"
+#include "segmentedhuffman.h"
+#include "bmplayout.h"
+#include "../FileStream/CopyCounter.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+
+namespace {
+
+typedef SegmentedHuffman::Segment Segment;
+
+// 一个可以直接复制编码数据的输入
+struct Source
+{
+    std::vector<std::vector<u64>> histograms;
+    std::unique_ptr<SegmentedHuffman> coder;
+    std::vector<Segment> segments;
+    std::vector<u64> starts;            // 各段在原始数据中的起点
+    std::vector<u8> owned;              // 重新编码的输入的位流
+    const std::vector<u8> *bytes = nullptr;
+    u64 size = 0;
+    std::vector<u8> header;             // 像素数据之前的部分
+    BmpLayout layout;
+    u64 rows = 0;
+
+    // 最近一次定位的位置，顺序处理同一段里的多个切口时不必每次从段首扫描
+    size_t cursor_segment = static_cast<size_t>(-1);
+    u64 cursor_symbol = 0;
+    u64 cursor_bit = 0;
+};
+
+// 原始数据中的一段范围
+struct Range
+{
+    Source *source;
+    u64 begin;
+    u64 length;
+};
+
+// 段内前symbol个符号占用的位数
+u64 locate(Source &source, size_t index, u64 symbol){
+    const Segment &segment = source.segments[index];
+    u64 from_symbol = 0;
+    u64 from_bit = 0;
+    if(source.cursor_segment == index && source.cursor_symbol <= symbol){
+        from_symbol = source.cursor_symbol;
+        from_bit = source.cursor_bit;
+    }
+    u64 bit = from_bit;
+    if(symbol > from_symbol){
+        bit = source.coder->skip(source.bytes->data() + segment.position, segment.coded_bytes, from_bit, segment.table, symbol - from_symbol);
+    }
+    source.cursor_segment = index;
+    source.cursor_symbol = symbol;
+    source.cursor_bit = bit;
+    return bit;
+}
+
+std::vector<u8> read(Source &source, u64 begin, u64 length){
+    std::vector<u8> result(length);
+    for(size_t i = 0; i < source.segments.size(); i++){
+        const Segment &segment = source.segments[i];
+        u64 first = std::max(begin, source.starts[i]);
+        u64 last = std::min(begin + length, source.starts[i] + segment.length);
+        if(first >= last){
+            continue;
+        }
+        u64 bit = locate(source, i, first - source.starts[i]);
+        source.coder->decodeRange(source.bytes->data() + segment.position, segment.coded_bytes, bit, segment.table,
+                                  result.data() + (first - begin), last - first);
+    }
+    return result;
+}
+
+std::unique_ptr<Source> open(const huf *hufFile, const std::string &dictionary){
+    std::unique_ptr<Source> source(new Source());
+    source->size = hufFile->bit_num;
+    HufCoder coder = static_cast<HufCoder>(hufFile->coder);
+    if(coder == HufCoder::SEGMENTED){
+        source->coder.reset(new SegmentedHuffman(hufFile->key_value_data));
+        for(u32 t = 0; t < source->coder->get_table_count(); t++){
+            source->histograms.push_back(source->coder->get_histogram(static_cast<u8>(t)));
+        }
+        source->segments = SegmentedHuffman::parseDirectory(hufFile->bitset);
+        source->bytes = &hufFile->bitset;
+    }else if(coder == HufCoder::HUFFMAN && hufFile->symbol_bits == 8){
+        // 按字节静态哈夫曼的位集整体就是一段，码表相同则编码相同
+        std::vector<u64> histogram(256, 0);
+        for(const auto &entry : hufFile->key_value_data){
+            if(entry.first > 0xFF){
+                throw std::runtime_error("Invalid symbol in frequency map");
+            }
+            histogram[entry.first] = entry.second;
+        }
+        source->histograms.push_back(histogram);
+        source->coder.reset(new SegmentedHuffman(source->histograms));
+        source->segments.push_back(Segment{hufFile->bit_num, 0, hufFile->bitset.size(), 0});
+        source->bytes = &hufFile->bitset;
+    }else if(coder == HufCoder::DELTA){
+        Logger::getInstance().error("差分文件需要先用参考图像解压");
+        throw std::runtime_error("Delta file needs its reference");
+    }else{
+        Logger::getInstance().info("编码后端 " + std::to_string(hufFile->coder) + " 的数据不能直接复制，解码后按字节哈夫曼编码");
+        std::vector<u8> data = bmpHandler::decodeHuf(hufFile, nullptr, dictionary);
+        std::vector<u64> histogram(256, 0);
+        for(u8 byte : data){
+            histogram[byte]++;
+        }
+        source->histograms.push_back(histogram);
+        source->coder.reset(new SegmentedHuffman(source->histograms));
+        source->segments.push_back(source->coder->encodeSegment(data.data(), data.size(), 0, source->owned));
+        source->bytes = &source->owned;
+    }
+
+    u64 start = 0;
+    for(const Segment &segment : source->segments){
+        source->starts.push_back(start);
+        start += segment.length;
+    }
+    if(start != source->size){
+        throw std::runtime_error("Segment lengths do not match bitNum");
+    }
+
+    std::vector<u8> head = read(*source, 0, std::min<u64>(BmpLayout::HEADER_BYTES, source->size));
+    source->layout = BmpLayout::parse(head.data(), source->size);
+    if(!source->layout.valid()){
+        Logger::getInstance().error("HUF文件的内容不是BMP图像");
+        throw std::runtime_error("Not a BMP image");
+    }
+    source->header = read(*source, 0, source->layout.offset);
+    int height = source->layout.height;
+    source->rows = static_cast<u64>(height < 0 ? -static_cast<long long>(height) : height);
+    if(source->layout.offset + source->rows * source->layout.row_bytes > source->size){
+        Logger::getInstance().error("像素数据不完整");
+        throw std::runtime_error("Truncated pixel data");
+    }
+    return source;
+}
+
+// 像素数据中显示顺序从first_row开始的row_count行在原始数据中的范围
+Range rows_range(Source &source, u64 first_row, u64 row_count){
+    u64 stored_first = source.layout.height > 0 ? source.rows - first_row - row_count : first_row;
+    return Range{&source, source.layout.offset + stored_first * source.layout.row_bytes, row_count * source.layout.row_bytes};
+}
+
+void write_le32(std::vector<u8> &bytes, size_t offset, u32 value){
+    for(int b = 0; b < 4; b++){
+        bytes[offset + b] = static_cast<u8>(value >> (8 * b));
+    }
+}
+
+// 由输入的文件头和新的行数生成输出，ranges按存储顺序排列
+huf *build(const Source &head_source, u64 rows, const std::vector<Range> &ranges){
+    std::vector<std::vector<u64>> histograms;
+    std::map<std::vector<u64>, u8> table_ids;
+    auto table_of = [&](const std::vector<u64> &histogram) -> u8 {
+        auto it = table_ids.find(histogram);
+        if(it != table_ids.end()){
+            return it->second;
+        }
+        if(histograms.size() >= SegmentedHuffman::MAX_TABLES){
+            Logger::getInstance().error("码表数量超过上限");
+            throw std::runtime_error("Too many tables");
+        }
+        u8 id = static_cast<u8>(histograms.size());
+        histograms.push_back(histogram);
+        table_ids[histogram] = id;
+        return id;
+    };
+
+    std::vector<Segment> segments;
+    std::vector<u8> payload;
+
+    // 新文件头是唯一需要重新编码的部分，单独一张码表
+    std::vector<u8> header = head_source.header;
+    u64 pixel_bytes = rows * head_source.layout.row_bytes;
+    write_le32(header, 2, static_cast<u32>(header.size() + pixel_bytes));
+    write_le32(header, 22, static_cast<u32>(head_source.layout.height < 0 ? -static_cast<long long>(rows) : static_cast<long long>(rows)));
+    write_le32(header, 34, static_cast<u32>(pixel_bytes));
+    std::vector<u64> header_histogram(256, 0);
+    for(u8 byte : header){
+        header_histogram[byte]++;
+    }
+    Segment header_segment = SegmentedHuffman(std::vector<std::vector<u64>>(1, header_histogram)).encodeSegment(header.data(), header.size(), 0, payload);
+    header_segment.table = table_of(header_histogram);
+    segments.push_back(header_segment);
+
+    u64 copied = 0;
+    u64 scanned = 0;
+    for(const Range &range : ranges){
+        Source &source = *range.source;
+        for(size_t i = 0; i < source.segments.size(); i++){
+            const Segment &segment = source.segments[i];
+            u64 first = std::max(range.begin, source.starts[i]);
+            u64 last = std::min(range.begin + range.length, source.starts[i] + segment.length);
+            if(first >= last){
+                continue;
+            }
+            const u8 *data = source.bytes->data() + segment.position;
+            Segment piece{last - first, table_of(source.histograms[segment.table]), 0, payload.size()};
+            if(first == source.starts[i] && last == source.starts[i] + segment.length){
+                // 整段原样复制
+                payload.insert(payload.end(), data, data + segment.coded_bytes);
+                CopyCounter::add(segment.coded_bytes);
+                copied += segment.length;
+            }else{
+                u64 bit_begin = locate(source, i, first - source.starts[i]);
+                u64 bit_end = locate(source, i, last - source.starts[i]);
+                SegmentedHuffman::copyBits(data, segment.coded_bytes, bit_begin, bit_end - bit_begin, payload);
+                scanned += last - first;
+            }
+            piece.coded_bytes = payload.size() - piece.position;
+            segments.push_back(piece);
+        }
+    }
+    Logger::getInstance().info("整段复制 " + std::to_string(copied) + " 字节，按位偏移复制 " + std::to_string(scanned) +
+                               " 字节，共 " + std::to_string(segments.size()) + " 段、" + std::to_string(histograms.size()) + " 张码表");
+
+    SegmentedHuffman coder(histograms);
+    huf *hufFile = new huf();
+    hufFile->coder = static_cast<u8>(HufCoder::SEGMENTED);
+    hufFile->coder_param = static_cast<u8>(histograms.size());
+    hufFile->key_size = 2;
+    hufFile->key_value_data = coder.get_frequency_map();
+    hufFile->key_num = hufFile->key_value_data.size();
+    hufFile->value_size = coder.get_frequency_length();
+    hufFile->bit_num = header.size() + pixel_bytes;
+    hufFile->bitset = SegmentedHuffman::assemble(segments, std::move(payload));
+    hufFile->bitset_size = hufFile->bitset.size();
+    return hufFile;
+}
+
+}
+
+huf *hufEdit::concat(const std::vector<const huf *> &parts, const std::string &dictionary){
+    if(parts.empty()){
+        throw std::runtime_error("Nothing to concatenate");
+    }
+    std::vector<std::unique_ptr<Source>> sources;
+    for(const huf *part : parts){
+        sources.push_back(open(part, dictionary));
+    }
+    const Source &first = *sources.front();
+    u64 rows = 0;
+    std::vector<Range> ranges;
+    for(auto &source : sources){
+        const BmpLayout &layout = source->layout;
+        // 调色板比较放在最后：文件头长度一致时才能逐字节比较
+        if(layout.width != first.layout.width || layout.bit_count != first.layout.bit_count || layout.offset != first.layout.offset ||
+           source->header.size() != first.header.size() || (layout.height < 0) != (first.layout.height < 0) ||
+           !std::equal(first.header.begin() + BmpLayout::HEADER_BYTES, first.header.end(),
+                       source->header.begin() + BmpLayout::HEADER_BYTES, source->header.end())){
+            Logger::getInstance().error("拼接的图像宽度、位深、存储方向或调色板不一致");
+            throw std::runtime_error("Incompatible images");
+        }
+        rows += source->rows;
+        ranges.push_back(rows_range(*source, 0, source->rows));
+    }
+    // 自下而上存储时，显示在最上面的部分位于像素数据的末尾
+    if(first.layout.height > 0){
+        std::reverse(ranges.begin(), ranges.end());
+    }
+    return build(first, rows, ranges);
+}
+
+huf *hufEdit::crop(const huf *hufFile, u32 first_row, u32 row_count, const std::string &dictionary){
+    std::unique_ptr<Source> source = open(hufFile, dictionary);
+    if(row_count == 0 || static_cast<u64>(first_row) + row_count > source->rows){
+        Logger::getInstance().error("裁剪范围超出图像行数");
+        throw std::runtime_error("Crop range out of bounds");
+    }
+    return build(*source, row_count, std::vector<Range>(1, rows_range(*source, first_row, row_count)));
+}
+
+std::vector<huf *> hufEdit::split(const huf *hufFile, u32 rows_per_part, const std::string &dictionary){
+    std::unique_ptr<Source> source = open(hufFile, dictionary);
+    if(rows_per_part == 0){
+        throw std::runtime_error("Rows per part must be positive");
+    }
+    u64 count = (source->rows + rows_per_part - 1) / rows_per_part;
+    std::vector<huf *> parts(count, nullptr);
+    try{
+        // 按存储顺序处理，同一段里的切口只需向后扫描一遍
+        for(u64 n = 0; n < count; n++){
+            u64 part = source->layout.height > 0 ? count - 1 - n : n;
+            u64 first_row = part * rows_per_part;
+            u64 row_count = std::min<u64>(rows_per_part, source->rows - first_row);
+            parts[part] = build(*source, row_count, std::vector<Range>(1, rows_range(*source, first_row, row_count)));
+        }
+    }catch(...){
+        for(huf *part : parts){
+            delete part;
+        }
+        throw;
+    }
+    return parts;
+}
+
+bool hufEdit::concatFiles(const std::vector<std::string> &inputs, const std::string &output, const std::string &dictionary){
+    Logger::getInstance().info("拼接 " + std::to_string(inputs.size()) + " 个HUF文件 -> " + output);
+    std::vector<std::unique_ptr<huf>> loaded;
+    std::vector<const huf *> parts;
+    for(const std::string &input : inputs){
+        loaded.emplace_back(hufHandler::load(input));
+        parts.push_back(loaded.back().get());
+    }
+    std::unique_ptr<huf> result(concat(parts, dictionary));
+    return hufHandler::save(output, result.get());
+}
+
+bool hufEdit::cropFile(const std::string &input, const std::string &output, u32 first_row, u32 row_count, const std::string &dictionary){
+    Logger::getInstance().info("裁剪HUF文件: " + input + " 第 " + std::to_string(first_row) + " 行起 " + std::to_string(row_count) + " 行 -> " + output);
+    std::unique_ptr<huf> hufFile(hufHandler::load(input));
+    std::unique_ptr<huf> result(crop(hufFile.get(), first_row, row_count, dictionary));
+    return hufHandler::save(output, result.get());
+}
+
+bool hufEdit::splitFile(const std::string &input, const std::string &output_prefix, u32 rows_per_part, const std::string &dictionary){
+    Logger::getInstance().info("切分HUF文件: " + input + " 每 " + std::to_string(rows_per_part) + " 行");
+    std::unique_ptr<huf> hufFile(hufHandler::load(input));
+    std::vector<huf *> parts = split(hufFile.get(), rows_per_part, dictionary);
+    bool result = true;
+    for(size_t i = 0; i < parts.size(); i++){
+        result = hufHandler::save(output_prefix + "_" + std::to_string(i) + ".huf", parts[i]) && result;
+        delete parts[i];
+    }
+    return result;
+}
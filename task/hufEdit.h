@@ -0,0 +1,36 @@
+#ifndef HUF_EDIT_H
+#define HUF_EDIT_H
+
+#include "hufHandler.h"
+#include <string>
+#include <vector>
+
+// 直接在压缩数据上拼接、切分、裁剪HUF文件，不经过BMP和完整的重新压缩
+// 结果统一为分段编码（HufCoder::SEGMENTED）：静态按字节哈夫曼和分段编码的输入，编码数据按段原样复制，
+// 只有切口所在的段需要按码长找出位偏移；新的BMP文件头作为边界单独建表编码。
+// 其他后端的输入先解码再按字节哈夫曼编码一次，差分文件需要先用参考图像解压
+// 行号均按显示顺序从上往下计
+class hufEdit
+{
+public:
+    // 按显示顺序从上到下纵向拼接，各部分的宽度、位深、存储方向和调色板必须一致
+    static huf *concat(const std::vector<const huf *> &parts, const std::string &dictionary = std::string());
+
+    // 取出从first_row开始的row_count行
+    static huf *crop(const huf *hufFile, u32 first_row, u32 row_count, const std::string &dictionary = std::string());
+
+    // 每rows_per_part行切成一个文件，最后一个可能不足
+    static std::vector<huf *> split(const huf *hufFile, u32 rows_per_part, const std::string &dictionary = std::string());
+
+    static bool concatFiles(const std::vector<std::string> &inputs, const std::string &output,
+                            const std::string &dictionary = std::string());
+
+    static bool cropFile(const std::string &input, const std::string &output, u32 first_row, u32 row_count,
+                         const std::string &dictionary = std::string());
+
+    // 输出为 output_prefix_0.huf、output_prefix_1.huf ...（自上而下）
+    static bool splitFile(const std::string &input, const std::string &output_prefix, u32 rows_per_part,
+                          const std::string &dictionary = std::string());
+};
+
+#endif // HUF_EDIT_H
@@ -5,6 +5,8 @@
 #include "../FileStream/FileHeadWriter.h"
 #include "../FileStream/FileFormat.h"
 #include "../logger/Logger.h"
+#include <algorithm>
+#include <memory>
 #include <vector>
 #include <unordered_map>
 
@@ -23,6 +25,10 @@ public:
     u64 key_num;         // 键值对数量
     u8 key_size;         // 键大小
     u8 value_size;       // 值大小
+    u8 coder = static_cast<u8>(HufCoder::HUFFMAN); // 熵编码后端
+    u8 coder_param = 0;  // 编码后端参数
+    u8 symbol_bits = 8;  // 符号位宽
+    u8 level = 0;        // 压缩级别，仅作记录，解码按coder分派
     
     virtual ~hufBase() = default;
     
@@ -43,142 +49,197 @@ public:
     // 使用vector存储键值对，而不是unordered_map
     // 每个元素是一对连续的键和值的字节数据
     std::unordered_map<u64,u64> key_value_data;
+
+    // 按小端序拼出size字节的整数
+    static u64 littleEndian(const u8 *bytes, u8 size) {
+        u64 value = 0;
+        for (int b = size - 1; b >= 0; b--) {
+            value = (value << 8) | bytes[b];
+        }
+        return value;
+    }
+
+    static void appendLittleEndian(std::vector<u8> &bytes, u64 value, u8 size) {
+        for (u8 b = 0; b < size; b++) {
+            bytes.push_back(static_cast<u8>(value >> (8 * b)));
+        }
+    }
     
+    // 码表占用的字节数，键值大小无效时抛出异常
+    u64 keyValueBytes() const {
+        auto valid_size = [](u8 size) { return size == 1 || size == 2 || size == 4 || size == 8; };
+        if (key_num > 0 && (!valid_size(key_size) || !valid_size(value_size))) {
+            Logger::getInstance().error("HUF键值对大小无效");
+            throw std::runtime_error("Invalid key/value size");
+        }
+        return key_num * (static_cast<u64>(key_size) + value_size);
+    }
+
     // 实现读取键值对数据的函数
     void readKeyValueData(FileHeadReader& reader) override {
         Logger::getInstance().info("开始读取HUF键值对数据");
+        // 整个码表一次读入，再按小端序逐项拆分
+        u64 table_size = keyValueBytes();
+        if (table_size > reader.getFileSize() - reader.tell()) {
+            Logger::getInstance().error("HUF键值对数量超出文件大小");
+            throw std::runtime_error("Key/value table truncated");
+        }
+        std::vector<u8> entries(table_size);
+        reader.readBlock(entries.data(), entries.size());
+        parseKeyValueData(entries.data());
+        Logger::getInstance().info("成功读取HUF键值对数据");
+    }
+
+    // 从内存中解析keyValueBytes()字节的码表
+    void parseKeyValueData(const u8 *entries) {
+        u64 entry_size = static_cast<u64>(key_size) + value_size;
+        key_value_data.reserve(key_num);
         for (u64 i = 0; i < key_num; ++i) {
-            u64 key;
-            switch(key_size){
-                case 1:{
-                    key = reader.readu8();
-                    break;
-                }
-                case 2:{
-                    key = reader.readu16();
-                    break;
-                }
-                case 4:{
-                    key = reader.readu32();
-                    break;
-                }
-                case 8:{
-                    key = reader.readu64();
-                    break;
-                }
-            }
-            u64 value;
-            switch(value_size){
-                case 1:{
-                    value = reader.readu8();
-                    break;
-                }
-                case 2:{
-                    value = reader.readu16();
-                    break;
-                }
-                case 4:{
-                    value = reader.readu32();
-                    break;
-                }
-                case 8:{
-                    value = reader.readu64();
-                    break;
-                }
-            }
+            u64 key = littleEndian(entries, key_size);
+            u64 value = littleEndian(entries + key_size, value_size);
             key_value_data.insert(std::make_pair(key, value));
+            entries += entry_size;
         }
         Logger::getInstance().debug("读取了 " + std::to_string(key_num) + " 个键值对");
-        Logger::getInstance().info("成功读取HUF键值对数据");
     }
 
     void writeKeyValueData(FileWriter &writer) const override {
+        std::vector<u8> entries;
+        appendKeyValueData(entries);
+        writer.writeBlock(entries.data(), entries.size());
+    }
+
+    // 把码表按小端序追加到bytes，保存时与文件头拼成一块写出
+    void appendKeyValueData(std::vector<u8> &bytes) const {
         Logger::getInstance().info("开始写入HUF键值对数据");
+        bytes.reserve(bytes.size() + key_value_data.size() * (key_size + value_size));
         for(auto &pair : key_value_data){
-           switch(key_size){
-                case 1:{
-                    u8 key = static_cast<u8>(pair.first);
-                    writer.writeu8(key);
-                    break;
-                }
-                case 2:{
-                    u16 key = static_cast<u16>(pair.first);
-                    writer.writeu16(key);
-                    break;
-                }
-                case 4:{
-                    u32 key = static_cast<u32>(pair.first);
-                    writer.writeu32(key);
-                    break;
-                }
-                case 8:{
-                    writer.writeu64(pair.first);
-                    break;
-                }
-           }
-
-           switch(value_size){
-                case 1:{
-                    u8 value = static_cast<u8>(pair.second);
-                    writer.writeu8(value);
-                    break;
-                }
-                case 2:{
-                    u16 value = static_cast<u16>(pair.second);
-                    writer.writeu16(value);
-                    break;
-                }
-                case 4:{
-                    u32 value = static_cast<u32>(pair.second);
-                    writer.writeu32(value);
-                    break;
-                }
-                case 8:{
-                    writer.writeu64(pair.second);
-                    break;
-                }
-           }
-
+            appendLittleEndian(bytes, pair.first, key_size);
+            appendLittleEndian(bytes, pair.second, value_size);
         }
         Logger::getInstance().info("成功写入HUF键值对数据");
     }
 
     void readBitsetData(FileHeadReader &reader) override {
         Logger::getInstance().info("开始读取HUF位集数据");
-        for(int i = 0; i < bitset_size; i++){
-            bitset.push_back(reader.readu8());
+        if (bitset_size > reader.getFileSize() - reader.tell()) {
+            Logger::getInstance().error("HUF位集大小超出文件大小");
+            throw std::runtime_error("Bitset truncated");
         }
+        bitset.resize(bitset_size);
+        reader.readBlock(bitset.data(), bitset_size);
         Logger::getInstance().debug("读取了 " + std::to_string(bitset_size) + " 字节位集数据");
         Logger::getInstance().info("成功读取HUF位集数据");
     }
 
     void writeBitsetData(FileWriter &writer) const override {
         Logger::getInstance().info("开始写入HUF位集数据");
-        for(int i = 0; i < bitset_size; i++){
-            writer.writeu8(bitset[i]);
-        }
+        writer.writeBlock(bitset.data(), bitset_size);
         Logger::getInstance().info("成功写入HUF位集数据");
     }
 
 
 };
 
+// 按级别自动选择后端时的取舍
+enum class HufTarget {
+    RATIO,      // 估算大小最小
+    BALANCED,   // 估算大小不超过最小值3%的候选中最快的
+    SPEED,      // 估算大小不超过最小值10%的候选中最快的
+};
+
+// 压缩选项
+struct HufOptions {
+    HufCoder coder = HufCoder::HUFFMAN; // 熵编码后端
+    u8 symbol_bits = 0;                 // 静态哈夫曼的符号位宽：0为按位深自动选择，4/8/16为指定
+    std::string reference;              // 参考图像（.bmp或非差分的.huf），非空时按参考帧差分编码
+    u8 table_id = 0xFF;                 // 预训练码表编号，0xFF为按估算大小自动选择
+    std::string dictionary;             // 预训练码表字典文件，为空时只使用内置表
+    u8 level = 0;                       // 压缩级别1-9（1最快，9压缩率最高），0为直接使用coder
+    HufTarget target = HufTarget::RATIO;
+    u8 sample_percent = 0;              // 抽样建表：按百分比抽取分散在全文件的64KB块统计频数，0为统计全部数据
+    bool memory_map = true;             // 映射输入文件直接编码，不先复制到内存（差分编码时总是读入）
+    bool map_populate = false;          // 映射时一次读入全部页面
+    WriteOptions output;                // 输出文件的预分配、O_DIRECT和持久化策略
+};
+
+// 压缩大小的预估结果（按静态哈夫曼），compressed_size与实际压缩输出的文件大小一致
+struct HufEstimate {
+    u64 original_size = 0;
+    u64 compressed_size = 0;
+    u8 symbol_bits = 8;
+    double entropy_size = 0; // 香农熵下界（字节），只含位流，不含文件头和码表
+
+    double ratio() const { return original_size > 0 ? 1.0 - static_cast<double>(compressed_size) / original_size : 0; }
+};
+
 class hufHandler
 {
 public:
     // 工厂函数，完全根据文件数据创建适当的huf对象
     static huf* load(const std::string &filename) {
         Logger::getInstance().info("正在加载HUF文件: " + filename);
-        // 先读取文件头以获取key_size和value_size
         FileHeadReader reader(filename);
-        std::unordered_map<std::string, u64> header = reader.getHeader();
-        u8 key_size = header["keySize"];
-        u8 value_size = header["valueSize"];
-        u64 key_num = header["keyNum"];
-        u64 bit_num = header["bitNum"];
-        u64 bitset_size = header["bitsetSize"];
+        huf* hufFile = loadHeader(reader);
+
+        hufFile->readBitsetData(reader);
+        
+        Logger::getInstance().info("成功加载HUF文件: " + filename);
+        return hufFile;
+    }
+
+    // 只读取文件头和键值对，reader停在位集数据的开头，供流式处理位集
+    static huf* loadHeader(FileHeadReader &reader) {
+        huf* hufFile = fromHeader(reader.getHeader<HufHeader>());
+        
+        // 移动到键值对数据部分
+        reader.toDataHeader();
+        
+        // 读取键值对数据
+        hufFile->readKeyValueData(reader);
+        return hufFile;
+    }
+
+    // 从内存中的完整HUF文件解析文件头和码表，位集不复制，bitset_offset为位集在bytes中的起点
+    static huf* parse(const u8 *bytes, u64 size, u64 &bitset_offset) {
+        if (size < sizeof(HufHeader)) {
+            Logger::getInstance().error("HUF文件头不完整");
+            throw std::runtime_error("Header truncated");
+        }
+        u64 position = sizeof(HufHeader);
+        std::unique_ptr<huf> hufFile(fromHeader(decode_header<HufHeader>(bytes)));
+        u64 table_size = hufFile->keyValueBytes();
+        if (table_size > size - position) {
+            Logger::getInstance().error("HUF键值对数量超出文件大小");
+            throw std::runtime_error("Key/value table truncated");
+        }
+        hufFile->parseKeyValueData(bytes + position);
+        bitset_offset = position + table_size;
+        if (hufFile->bitset_size > size - bitset_offset) {
+            Logger::getInstance().error("HUF位集大小超出文件大小");
+            throw std::runtime_error("Bitset truncated");
+        }
+        return hufFile.release();
+    }
+
+    // 按文件头各字段创建huf对象，码表和位集由调用者读取
+    static huf* fromHeader(const HufHeader &header) {
+        u8 key_size = header.keySize;
+        u8 value_size = header.valueSize;
+        u64 key_num = header.keyNum;
+        u64 bit_num = header.bitNum;
+        u64 bitset_size = header.bitsetSize;
+        u8 coder = header.coder;
+        u8 coder_param = header.coderParam;
+        u8 symbol_bits = header.symbolBits;
+        u8 level = header.level;
+        if (symbol_bits == 0) {
+            symbol_bits = 8; // 旧文件该字段为保留的0
+        }
         
-        Logger::getInstance().debug("HUF文件头信息 - KeySize: " + std::to_string(key_size) + 
+        Logger::getInstance().debug("HUF文件头信息 - Coder: " + std::to_string(coder) +
+                                   ", SymbolBits: " + std::to_string(symbol_bits) +
+                                   ", KeySize: " + std::to_string(key_size) + 
                                    ", ValueSize: " + std::to_string(value_size) +
                                    ", KeyNum: " + std::to_string(key_num) +
                                    ", BitNum: " + std::to_string(bit_num) +
@@ -193,39 +254,94 @@ public:
         hufFile->key_num = key_num;
         hufFile->bit_num = bit_num;
         hufFile->bitset_size = bitset_size;
-        
-        // 移动到键值对数据部分
-        reader.toDataHeader();
-        
-        // 读取键值对数据
-        hufFile->readKeyValueData(reader);
-
-        hufFile->readBitsetData(reader);
-        
-        Logger::getInstance().info("成功加载HUF文件: " + filename);
+        hufFile->coder = coder;
+        hufFile->coder_param = coder_param;
+        hufFile->symbol_bits = symbol_bits;
+        hufFile->level = level;
         return hufFile;
     }
     
 public:
-    static bool bmp2huf_start(const std::string &filename, const std::string &output_filename, double *process); // bmp加载器加载，读取头和像素数，遍历数据建树，生成位流，保存至huf文件
+    static bool bmp2huf_start(const std::string &filename, const std::string &output_filename, double *process,
+                              const HufOptions &options = HufOptions()); // bmp加载器加载，读取头和像素数，遍历数据建树，生成位流，保存至huf文件
 
-    // 保存HUF文件
-    static bool save(const std::string &filename, const huf* hufFile) {
-        Logger::getInstance().info("正在保存HUF文件: " + filename);
-        u32 size = 32; // hufType(2B) + fileSize(4B) + reserved(4B) + keySize(1B) + valueSize(1B) + keyNum(4B) + bitNum(8B) + bitsetSize(8B) = 32B
+    static constexpr u8 MAX_LEVEL = 9;
+
+    // 按指定后端在内存中编码，返回的对象由调用者释放
+    static huf *encodeHuf(const std::vector<u8> &data, HufCoder coder, const HufOptions &options);
+    static huf *encodeHuf(const u8 *data, u64 size, HufCoder coder, const HufOptions &options);
+
+    // 按options压缩内存中的BMP数据：按级别选择后端、压缩后更大时改为直接存储，不处理差分和流式自适应
+    static huf *compress(const u8 *data, u64 size, const HufOptions &options);
+
+    // 与参考图像数据逐字节求差后编码，data被就地改写为残差
+    static huf *compressDelta(std::vector<u8> &data, const std::vector<u8> &reference, const HufOptions &options);
+
+    // 按压缩级别的候选后端，在输入的抽样上试编码并估算大小，选出后端
+    // 只统计直方图、建树，由码长计算静态哈夫曼输出的精确大小，不编码也不写文件；大文件多线程统计
+    static HufEstimate estimate(const std::string &filename, const HufOptions &options = HufOptions());
+
+    static HufCoder chooseCoder(const std::vector<u8> &data, const HufOptions &options);
+    static HufCoder chooseCoder(const u8 *data, u64 size, const HufOptions &options);
+
+    static bool bmp2huf_stream(const std::string &filename, const std::string &output_filename, double *process,
+                               const WriteOptions &output = WriteOptions()); // 单遍自适应哈夫曼：按块读取、编码并立即输出，结束后回填文件头
+
+    // 写入32字节的固定文件头
+    static void writeHeader(FileWriter &writer, const hufBase *hufFile, u32 size) {
+        std::vector<u8> header;
+        appendHeader(header, hufFile, size);
+        writer.writeBlock(header.data(), header.size());
+    }
+
+    static void appendHeader(std::vector<u8> &bytes, const hufBase *hufFile, u32 size) {
+        HufHeader header;
+        header.hufType = 0x5546; // 'U'是0x55，'F'是0x46
+        header.fileSize = size;
+        header.coder = hufFile->coder;
+        header.coderParam = hufFile->coder_param;
+        header.symbolBits = hufFile->symbol_bits;
+        header.level = hufFile->level;
+        header.keySize = hufFile->key_size;
+        header.valueSize = hufFile->value_size;
+        header.keyNum = static_cast<u32>(hufFile->key_num);
+        header.bitNum = hufFile->bit_num;
+        header.bitsetSize = hufFile->bitset_size;
+        size_t position = bytes.size();
+        bytes.resize(position + sizeof(HufHeader));
+        encode_header(header, bytes.data() + position);
+    }
+
+    // 文件总大小
+    static u64 fileSize(const hufBase *hufFile) {
+        u64 size = sizeof(HufHeader); // hufType(2B) + fileSize(4B) + coder(1B) + coderParam(1B) + symbolBits(1B) + level(1B) + keySize(1B) + valueSize(1B) + keyNum(4B) + bitNum(8B) + bitsetSize(8B) = 32B
         size += hufFile->bitset_size;
         size += hufFile->key_num * hufFile->key_size;
         size += hufFile->key_num * hufFile->value_size;
-        FileWriter writer(filename);
-        writer.writeu16(0x5546); // 'U'是0x55，'F'是0x46
-        writer.writeu32(size);
-        writer.writeu32(0);
-        writer.writeu8(hufFile->key_size);
-        writer.writeu8(hufFile->value_size);
-        writer.writeu32(static_cast<u32>(hufFile->key_num));
-        writer.writeu64(hufFile->bit_num);
-        writer.writeu64(hufFile->bitset_size);
-        hufFile->writeKeyValueData(writer);
+        return size;
+    }
+
+    // 完整的文件内容（文件头 + 码表 + 位集），供批量异步写出
+    static std::vector<u8> serialize(const huf *hufFile) {
+        u64 size = fileSize(hufFile);
+        std::vector<u8> bytes;
+        bytes.reserve(size);
+        appendHeader(bytes, hufFile, static_cast<u32>(size));
+        hufFile->appendKeyValueData(bytes);
+        bytes.insert(bytes.end(), hufFile->bitset.begin(), hufFile->bitset.begin() + hufFile->bitset_size);
+        return bytes;
+    }
+
+    // 保存HUF文件，文件大小已知，可按options预分配并在大文件时绕过页缓存
+    static bool save(const std::string &filename, const huf* hufFile, const WriteOptions &options = WriteOptions()) {
+        Logger::getInstance().info("正在保存HUF文件: " + filename);
+        u32 size = static_cast<u32>(fileSize(hufFile));
+        FileWriter writer(filename, options, fileSize(hufFile));
+        // 文件头和码表先在内存中拼成一块，与位集一起交给文件流，不再逐个值写入
+        std::vector<u8> head;
+        appendHeader(head, hufFile, size);
+        hufFile->appendKeyValueData(head);
+        writer.writeBlock(head.data(), head.size());
         hufFile->writeBitsetData(writer);
         bool result = writer.close();
         if (result) {
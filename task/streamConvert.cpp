@@ -0,0 +1,262 @@
+#include "streamConvert.h"
+#include "bmpHandler.h"
+#include "huffmantree.h"
+#include "huffmanlookup.h"
+#include "pretrained.h"
+#include "bitio.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+namespace {
+
+size_t window_of(const StreamOptions &options){
+    return std::max(options.window, streamConvert::MIN_WINDOW);
+}
+
+// 读满buffer或读到文件末尾，返回读入的字节数
+size_t read_window(FileReader &reader, u8 *buffer, size_t size){
+    size_t filled = 0;
+    while(filled < size){
+        size_t count = reader.readSome(buffer + filled, size - filled);
+        if(count == 0){
+            break;
+        }
+        filled += count;
+    }
+    return filled;
+}
+
+void report(double *process, u64 done, u64 total){
+    if(process){
+        *process = total > 0 ? static_cast<double>(done) / total : 1.0;
+    }
+}
+
+// 逐窗口读入位集并查表解码，输出攒满一个窗口就写出。
+// 窗口中剩下的位足够多少个最长码字就先解码多少个符号，不足一个最长码字的位留到下一个窗口，窗口之间按位衔接
+void decode_windows(FileHeadReader &reader, FileWriter &writer, const HuffmanLookup<u8> &decoder, u64 bitset_size,
+                    u64 code_num, size_t window, double *process){
+    std::vector<u8> input(window);
+    std::vector<u8> output(window);
+    const u32 max_code_bits = std::max<u32>(decoder.max_length(), 1);
+    u64 remaining = bitset_size; // 位集中尚未读入的字节
+    size_t filled = 0;           // input中的有效字节
+    u32 bit_offset = 0;          // input开头已经解码过的位
+    size_t used = 0;             // output中的有效字节
+    u64 decoded = 0;
+    while(decoded < code_num){
+        size_t count = read_window(reader, input.data() + filled, static_cast<size_t>(std::min<u64>(remaining, window - filled)));
+        filled += count;
+        remaining -= count;
+        if(count == 0 && remaining > 0){
+            Logger::getInstance().error("HUF位集大小超出文件大小");
+            throw std::runtime_error("Bitset truncated");
+        }
+
+        BitReader bits(input.data(), filled);
+        bits.skip(bit_offset);
+        bool last = remaining == 0;
+        while(decoded < code_num){
+            u64 symbols = std::min<u64>(code_num - decoded, output.size() - used);
+            if(!last){
+                symbols = std::min<u64>(symbols, (bits.bitSize() - bits.tell()) / max_code_bits);
+            }
+            if(symbols == 0){
+                break;
+            }
+            decoder.decodeInto(bits, output.data() + used, symbols);
+            used += static_cast<size_t>(symbols);
+            decoded += symbols;
+            if(used == output.size()){
+                writer.writeBlock(output.data(), used);
+                used = 0;
+                report(process, decoded, code_num);
+            }
+        }
+        if(last){
+            if(bits.overrun()){
+                Logger::getInstance().error("Decoded count not equal to code number");
+                throw std::runtime_error("Decoded count not equal to code number");
+            }
+            break;
+        }
+
+        // 已解码的整字节移出窗口，剩下的与下一次读入的数据拼接
+        size_t consumed = static_cast<size_t>(bits.tell() / 8);
+        bit_offset = static_cast<u32>(bits.tell() % 8);
+        std::memmove(input.data(), input.data() + consumed, filled - consumed);
+        filled -= consumed;
+    }
+    writer.writeBlock(output.data(), used);
+}
+
+// 直接存储的位集就是原始数据，逐窗口复制
+void copy_windows(FileHeadReader &reader, FileWriter &writer, u64 size, size_t window, double *process){
+    std::vector<u8> buffer(window);
+    for(u64 done = 0; done < size;){
+        size_t count = read_window(reader, buffer.data(), static_cast<size_t>(std::min<u64>(window, size - done)));
+        if(count == 0){
+            Logger::getInstance().error("HUF位集大小超出文件大小");
+            throw std::runtime_error("Bitset truncated");
+        }
+        writer.writeBlock(buffer.data(), count);
+        done += count;
+        report(process, done, size);
+    }
+}
+
+}
+
+bool streamConvert::supports(const huf *hufFile){
+    HufCoder coder = static_cast<HufCoder>(hufFile->coder);
+    return (coder == HufCoder::HUFFMAN && hufFile->symbol_bits == 8) || coder == HufCoder::PRETRAINED ||
+           coder == HufCoder::STORED;
+}
+
+bool streamConvert::bmp2huf(const std::string &filename, const std::string &output_filename, double *process,
+                            const StreamOptions &options){
+    Logger::getInstance().info("开始窗口流式BMP到HUF转换任务: " + filename + " -> " + output_filename);
+    const size_t window = window_of(options);
+    std::vector<u8> buffer(window);
+    FileReader reader(filename);
+
+    // 第一遍：逐窗口统计直方图
+    Logger::getInstance().debug("逐窗口统计直方图");
+    std::vector<u64> histogram(256, 0);
+    u64 size = 0;
+    while(true){
+        size_t count = read_window(reader, buffer.data(), window);
+        for(size_t i = 0; i < count; i++){
+            histogram[buffer[i]]++;
+        }
+        size += count;
+        if(count < window){
+            break;
+        }
+    }
+
+    huf hufFile;
+    hufFile.coder = static_cast<u8>(HufCoder::HUFFMAN);
+    hufFile.key_size = sizeof(unsigned char);
+    hufFile.bit_num = size;
+
+    // 建树，位集大小由码长准确算出，文件头和码表可以先写出，输出文件按最终大小预分配
+    std::vector<std::pair<u64, u8>> codes(256);
+    u64 bits = 0;
+    if(size > 0){
+        std::unordered_map<u8, u64> frequency_map;
+        for(u32 s = 0; s < 256; s++){
+            if(histogram[s] > 0){
+                frequency_map[static_cast<u8>(s)] = histogram[s];
+            }
+        }
+        HuffmanTree<u8> tree;
+        tree.input_data(frequency_map);
+        tree.spawnTree();
+        for(auto &code : tree.get_code_map()){
+            codes[code.first] = code.second;
+            bits += histogram[code.first] * code.second.second;
+        }
+        hufFile.value_size = tree.get_frequency_length();
+        for(auto &entry : frequency_map){
+            hufFile.key_value_data.insert(std::make_pair(static_cast<u64>(entry.first), entry.second));
+        }
+    }else{
+        hufFile.value_size = 1;
+    }
+    hufFile.key_num = hufFile.key_value_data.size();
+    hufFile.bitset_size = (bits + 7) / 8;
+
+    u64 file_size = hufHandler::fileSize(&hufFile);
+    FileWriter writer(output_filename, options.output, file_size);
+    std::vector<u8> head;
+    hufHandler::appendHeader(head, &hufFile, static_cast<u32>(file_size));
+    hufFile.appendKeyValueData(head);
+    writer.writeBlock(head.data(), head.size());
+
+    // 第二遍：逐窗口编码，位流攒满一个窗口就写出
+    Logger::getInstance().debug("逐窗口编码位流数据");
+    reader.seek(0);
+    BitWriter encoder;
+    encoder.reserve(window + 64);
+    u64 written = 0;
+    auto flush = [&](std::vector<u8> &&bytes){
+        writer.writeBlock(bytes.data(), bytes.size());
+        written += bytes.size();
+    };
+    for(u64 done = 0; done < size;){
+        size_t count = read_window(reader, buffer.data(), static_cast<size_t>(std::min<u64>(window, size - done)));
+        if(count == 0){
+            Logger::getInstance().error("读取BMP文件失败: " + filename);
+            throw std::runtime_error("Input changed while streaming");
+        }
+        for(size_t i = 0; i < count; i++){
+            const std::pair<u64, u8> &code = codes[buffer[i]];
+            encoder.put(code.first, code.second);
+            if(encoder.bitCount() >= static_cast<u64>(window) * 8){
+                flush(encoder.takeBytes());
+                encoder.reserve(window + 64);
+            }
+        }
+        done += count;
+        report(process, done, size);
+    }
+    flush(encoder.finish());
+    if(written != hufFile.bitset_size){
+        Logger::getInstance().error("位集大小与建表时计算的不一致");
+        throw std::runtime_error("Bitset size mismatch");
+    }
+
+    bool result = writer.close();
+    Logger::getInstance().info("完成窗口流式BMP到HUF转换任务");
+    return result;
+}
+
+bool streamConvert::huf2bmp(const std::string &filename, const std::string &output_filename, double *process,
+                            const std::string &dictionary, const StreamOptions &options){
+    FileHeadReader reader(filename);
+    std::unique_ptr<huf> hufFile(hufHandler::loadHeader(reader));
+    if(!supports(hufFile.get())){
+        Logger::getInstance().info("该编码后端不支持按窗口解码，改为映射文件解码");
+        return bmpHandler::huf2bmp_start(filename, output_filename, process, std::string(), dictionary, options.output);
+    }
+
+    Logger::getInstance().info("开始窗口流式HUF到BMP转换任务: " + filename + " -> " + output_filename);
+    const size_t window = window_of(options);
+    HufCoder coder = static_cast<HufCoder>(hufFile->coder);
+    try{
+        FileWriter writer(output_filename, options.output, hufFile->bit_num);
+        if(coder == HufCoder::STORED){
+            if(hufFile->bitset_size != hufFile->bit_num){
+                throw std::runtime_error("Stored size mismatch");
+            }
+            copy_windows(reader, writer, hufFile->bit_num, window, process);
+        }else if(coder == HufCoder::PRETRAINED){
+            std::shared_ptr<const PretrainedTables::Table> table = PretrainedTables::get(hufFile->coder_param, dictionary);
+            decode_windows(reader, writer, *table->lookup, hufFile->bitset_size, hufFile->bit_num, window, process);
+        }else if(hufFile->bit_num > 0){
+            std::unordered_map<u8, u64> frequency_map;
+            for(auto &entry : hufFile->key_value_data){
+                frequency_map[static_cast<u8>(entry.first)] = entry.second;
+            }
+            HuffmanTree<u8> tree;
+            tree.input_data(frequency_map);
+            tree.spawnTree();
+            HuffmanLookup<u8> decoder(tree.get_root());
+            decode_windows(reader, writer, decoder, hufFile->bitset_size, hufFile->bit_num, window, process);
+        }
+        if(!writer.close()){
+            Logger::getInstance().error("保存BMP文件失败: " + output_filename);
+            std::remove(output_filename.c_str());
+            return false;
+        }
+    }catch(...){
+        // 不留下解了一半的输出文件
+        std::remove(output_filename.c_str());
+        throw;
+    }
+    Logger::getInstance().info("完成窗口流式HUF到BMP转换任务");
+    return true;
+}
@@ -0,0 +1,35 @@
+#ifndef STREAM_CONVERT_H
+#define STREAM_CONVERT_H
+
+#include "hufHandler.h"
+#include <string>
+
+// 定长窗口的流式转换选项
+struct StreamOptions {
+    size_t window = 1u << 20; // 输入窗口和输出窗口的大小（字节），不小于MIN_WINDOW
+    WriteOptions output;      // 输出文件的预分配、O_DIRECT和持久化策略
+};
+
+// 内存有界的流式转换：输入和输出都经过定长窗口，不把整个文件读入内存。
+// 压缩为两遍：第一遍逐窗口统计直方图并建树，由码长算出位集的准确大小后写出文件头和码表；
+// 第二遍逐窗口编码，位流攒满一个窗口就写出。解压时逐窗口读入位集，解码结果攒满一个窗口就写出。
+// 每个任务的堆内存约为两个窗口加上读写缓冲和码表，与文件大小无关。
+// 压缩输出为按字节静态哈夫曼（HufCoder::HUFFMAN，symbolBits为8），任何解压方式都能读取；
+// 解压支持按字节静态哈夫曼、预训练码表和直接存储，其他后端改为映射文件解码（bmpHandler::huf2bmp_start）
+class streamConvert
+{
+public:
+    static constexpr size_t MIN_WINDOW = 64u << 10;
+
+    static bool bmp2huf(const std::string &filename, const std::string &output_filename, double *process,
+                        const StreamOptions &options = StreamOptions());
+
+    // 使用字典码表的文件需提供字典
+    static bool huf2bmp(const std::string &filename, const std::string &output_filename, double *process,
+                        const std::string &dictionary = std::string(), const StreamOptions &options = StreamOptions());
+
+    // 该后端的文件能否按窗口解码
+    static bool supports(const huf *hufFile);
+};
+
+#endif // STREAM_CONVERT_H
@@ -1,13 +1,25 @@
 #ifndef SUBMIT_CONVERT_TASK_H
 #define SUBMIT_CONVERT_TASK_H
 #include "../FileTaskPool/threadPool.h" // 使用改进后的线程池
+#include "../FileTaskPool/prefetcher.h"
 #include "bmpHandler.h"
 #include "hufHandler.h"
+#include "batchConvert.h"
+#include "streamConvert.h"
 #include <functional>
 
+// 全局输入预读器，按任务队列顺序预读输入、丢弃已处理输入的页缓存
+inline Prefetcher &gPrefetcher()
+{
+    static Prefetcher prefetcher;
+    return prefetcher;
+}
+
 // 全局线程池对象（懒加载，线程安全）
 inline ThreadPool &gPool()
 {
+    // 预读器先于线程池构造、后于线程池析构，线程池析构时等待的任务仍可使用它
+    gPrefetcher();
     static ThreadPool pool(std::thread::hardware_concurrency());
     return pool;
 }
@@ -16,19 +28,81 @@ inline ThreadPool &gPool()
 inline std::future<bool> submit_huf2bmp(const std::string &input_path, const std::string &output_path, double *progress)
 {
     Logger::getInstance().info("提交HUF到BMP转换任务");
+    gPrefetcher().enqueue(input_path);
     return gPool().submit_with_result([input_path, output_path, progress]() {
+        Prefetcher::Scope scope(gPrefetcher(), input_path);
         bmpHandler handler;
         return handler.huf2bmp_start(input_path, output_path, progress);
     });
 }
 
 // 提交BMP到HUF转换任务
-inline std::future<bool> submit_bmp2huf(const std::string &input_path, const std::string &output_path, double *progress)
+inline std::future<bool> submit_bmp2huf(const std::string &input_path, const std::string &output_path, double *progress,
+                                        const HufOptions &options = HufOptions())
 {
     Logger::getInstance().info("提交BMP到HUF转换任务");
-    return gPool().submit_with_result([input_path, output_path, progress]() {
+    gPrefetcher().enqueue(input_path);
+    return gPool().submit_with_result([input_path, output_path, progress, options]() {
+        Prefetcher::Scope scope(gPrefetcher(), input_path);
         hufHandler handler;
-        return handler.bmp2huf_start(input_path, output_path, progress);
+        return handler.bmp2huf_start(input_path, output_path, progress, options);
+    });
+}
+
+// 提交压缩大小预估任务（不写文件）
+inline std::future<HufEstimate> submit_estimate(const std::string &input_path)
+{
+    Logger::getInstance().info("提交压缩预估任务");
+    gPrefetcher().enqueue(input_path);
+    return gPool().submit_with_result([input_path]() {
+        Prefetcher::Scope scope(gPrefetcher(), input_path);
+        return hufHandler::estimate(input_path);
+    });
+}
+
+// 提交内存有界的流式压缩任务，每个任务的堆内存由options.window决定，与文件大小无关
+inline std::future<bool> submit_bmp2huf_bounded(const std::string &input_path, const std::string &output_path, double *progress,
+                                                const StreamOptions &options = StreamOptions())
+{
+    Logger::getInstance().info("提交窗口流式BMP到HUF转换任务");
+    gPrefetcher().enqueue(input_path);
+    return gPool().submit_with_result([input_path, output_path, progress, options]() {
+        Prefetcher::Scope scope(gPrefetcher(), input_path);
+        return streamConvert::bmp2huf(input_path, output_path, progress, options);
+    });
+}
+
+// 提交内存有界的流式解压任务
+inline std::future<bool> submit_huf2bmp_bounded(const std::string &input_path, const std::string &output_path, double *progress,
+                                                const StreamOptions &options = StreamOptions())
+{
+    Logger::getInstance().info("提交窗口流式HUF到BMP转换任务");
+    gPrefetcher().enqueue(input_path);
+    return gPool().submit_with_result([input_path, output_path, progress, options]() {
+        Prefetcher::Scope scope(gPrefetcher(), input_path);
+        return streamConvert::huf2bmp(input_path, output_path, progress, std::string(), options);
+    });
+}
+
+// 提交批量BMP到HUF转换任务
+// 批量任务本身等待线程池中的编码任务，不能占用线程池的线程，单独在一个线程上运行
+inline std::future<std::vector<bool>> submit_bmp2huf_batch(const std::vector<std::string> &input_paths,
+                                                           const std::vector<std::string> &output_paths, double *progress,
+                                                           const HufOptions &options = HufOptions())
+{
+    Logger::getInstance().info("提交批量BMP到HUF转换任务");
+    return std::async(std::launch::async, [input_paths, output_paths, progress, options]() {
+        return batchConvert::bmp2huf(input_paths, output_paths, progress, options);
+    });
+}
+
+// 提交批量HUF到BMP转换任务
+inline std::future<std::vector<bool>> submit_huf2bmp_batch(const std::vector<std::string> &input_paths,
+                                                           const std::vector<std::string> &output_paths, double *progress)
+{
+    Logger::getInstance().info("提交批量HUF到BMP转换任务");
+    return std::async(std::launch::async, [input_paths, output_paths, progress]() {
+        return batchConvert::huf2bmp(input_paths, output_paths, progress);
     });
 }
 
@@ -45,4 +119,7 @@ inline size_t getThreadPoolActiveTasks()
 
 inline size_t getThreadPoolThreadCount() { return gPool().thread_count(); }
 
+// 配置输入预读深度和是否丢弃已处理输入的页缓存，单个任务和批量转换共用
+inline void setPrefetchOptions(const PrefetchOptions &options) { gPrefetcher().configure(options); }
+
 #endif
\ No newline at end of file
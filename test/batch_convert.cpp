@@ -0,0 +1,57 @@
+#include "task/batchConvert.h"
+#include "logger/Logger.h"
+#include <chrono>
+#include <iostream>
+
+// 批量转换工具：异步读写输入输出，线程池编解码
+//   batch_convert compress <输出目录> <输入.bmp...>     输出为 目录/文件名.huf
+//   batch_convert decompress <输出目录> <输入.huf...>   输出为 目录/文件名.bmp
+static void usage() {
+    std::cout << "用法:\n"
+              << "  batch_convert compress <输出目录> <输入.bmp...>\n"
+              << "  batch_convert decompress <输出目录> <输入.huf...>\n";
+}
+
+static std::string output_path(const std::string &directory, const std::string &input, const std::string &suffix) {
+    std::string name = input.substr(input.find_last_of("/\\") + 1);
+    return directory + "/" + name.substr(0, name.find_last_of('.')) + suffix;
+}
+
+int main(int argc, char *argv[]) {
+    Logger::getInstance().setLogLevel(LogLevel::WARNING);
+    if (argc < 4) {
+        usage();
+        return 1;
+    }
+    std::string command = argv[1];
+    if (command != "compress" && command != "decompress") {
+        usage();
+        return 1;
+    }
+    std::vector<std::string> inputs(argv + 3, argv + argc);
+    std::vector<std::string> outputs;
+    for (const std::string &input : inputs) {
+        outputs.push_back(output_path(argv[2], input, command == "compress" ? ".huf" : ".bmp"));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<bool> results;
+    try {
+        results = command == "compress" ? batchConvert::bmp2huf(inputs, outputs, nullptr)
+                                        : batchConvert::huf2bmp(inputs, outputs, nullptr);
+    } catch (const std::exception &e) {
+        std::cerr << "失败: " << e.what() << std::endl;
+        return 1;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    size_t failed = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        if (!results[i]) {
+            std::cerr << "失败: " << inputs[i] << std::endl;
+            failed++;
+        }
+    }
+    std::cout << inputs.size() - failed << "/" << inputs.size() << " 个文件成功，用时 " << elapsed.count() << " ms" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+#include "task/hufEdit.h"
+#include "logger/Logger.h"
+#include <iostream>
+
+// HUF文件压缩域编辑工具，行号按显示顺序从上往下计
+//   huf_edit concat <输出.huf> <输入.huf...>                 纵向拼接
+//   huf_edit crop <输入.huf> <输出.huf> <起始行> <行数>      裁剪
+//   huf_edit split <输入.huf> <输出前缀> <每份行数>           切分为 前缀_0.huf、前缀_1.huf ...
+// 使用字典码表的预训练文件可在最后加 --dict <字典文件>
+static void usage() {
+    std::cout << "用法:\n"
+              << "  huf_edit concat <输出.huf> <输入.huf...> [--dict <字典>]\n"
+              << "  huf_edit crop <输入.huf> <输出.huf> <起始行> <行数> [--dict <字典>]\n"
+              << "  huf_edit split <输入.huf> <输出前缀> <每份行数> [--dict <字典>]\n";
+}
+
+int main(int argc, char *argv[]) {
+    Logger::getInstance().setLogLevel(LogLevel::WARNING);
+    std::string dictionary;
+    if (argc >= 3 && std::string(argv[argc - 2]) == "--dict") {
+        dictionary = argv[argc - 1];
+        argc -= 2;
+    }
+    if (argc < 4) {
+        usage();
+        return 1;
+    }
+    std::string command = argv[1];
+    bool ok = false;
+    try {
+        if (command == "concat") {
+            std::vector<std::string> inputs(argv + 3, argv + argc);
+            ok = hufEdit::concatFiles(inputs, argv[2], dictionary);
+        } else if (command == "crop" && argc == 6) {
+            ok = hufEdit::cropFile(argv[2], argv[3], static_cast<u32>(std::stoul(argv[4])),
+                                   static_cast<u32>(std::stoul(argv[5])), dictionary);
+        } else if (command == "split" && argc == 5) {
+            ok = hufEdit::splitFile(argv[2], argv[3], static_cast<u32>(std::stoul(argv[4])), dictionary);
+        } else {
+            usage();
+            return 1;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "失败: " << e.what() << std::endl;
+        return 1;
+    }
+    if (!ok) {
+        std::cerr << "写入输出失败" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,250 @@
+#include "task/hufHandler.h"
+#include "task/bmpHandler.h"
+#include "task/streamConvert.h"
+#include "FileStream/CopyCounter.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// 大缓冲预算测试：统计一次转换中的堆分配和批量复制的字节数，防止重新引入整份数据的复制
+// 复制到新缓冲时需要一块与数据同量级的分配，由“大分配次数”统计；复制进已有缓冲或映射的数据
+// 不产生分配，由CopyCounter在读写缓冲、位流拼接等批量路径上累计。同时检查转换期间堆内存的峰值增量
+
+namespace {
+struct AllocStats {
+    size_t live = 0;        // 当前存活字节
+    size_t peak = 0;        // 统计开始后的存活峰值
+    size_t large = 0;       // 不小于threshold的分配次数
+    size_t large_bytes = 0; // 这些分配的总字节数
+    size_t threshold = static_cast<size_t>(-1);
+};
+
+AllocStats stats;
+
+// 块前保存分配大小，释放时扣除
+const size_t HEADER = alignof(std::max_align_t);
+
+void *counted_alloc(size_t size) {
+    void *raw = std::malloc(size + HEADER);
+    if (raw == nullptr) {
+        throw std::bad_alloc();
+    }
+    *static_cast<size_t *>(raw) = size;
+    stats.live += size;
+    if (stats.live > stats.peak) {
+        stats.peak = stats.live;
+    }
+    if (size >= stats.threshold) {
+        stats.large++;
+        stats.large_bytes += size;
+    }
+    return static_cast<char *>(raw) + HEADER;
+}
+
+void counted_free(void *pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+    char *raw = static_cast<char *>(pointer) - HEADER;
+    stats.live -= *reinterpret_cast<size_t *>(raw);
+    std::free(raw);
+}
+}
+
+void *operator new(size_t size) { return counted_alloc(size); }
+void *operator new[](size_t size) { return counted_alloc(size); }
+void operator delete(void *pointer) noexcept { counted_free(pointer); }
+void operator delete[](void *pointer) noexcept { counted_free(pointer); }
+void operator delete(void *pointer, size_t) noexcept { counted_free(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { counted_free(pointer); }
+
+namespace {
+unsigned long long copied_before = 0;
+
+// 从这里开始统计，大分配的门槛为数据量的四分之一
+void begin(size_t data_size) {
+    stats.peak = stats.live;
+    stats.large = 0;
+    stats.large_bytes = 0;
+    stats.threshold = data_size / 4;
+    copied_before = CopyCounter::bytes();
+}
+
+struct Usage {
+    size_t peak;
+    size_t large;
+    size_t copied;
+};
+
+Usage end(size_t baseline) {
+    stats.threshold = static_cast<size_t>(-1);
+    return Usage{stats.peak - baseline, stats.large, static_cast<size_t>(CopyCounter::bytes() - copied_before)};
+}
+
+// 2048x2048的24位BMP（12MB），大分配门槛远高于1MB的读写缓冲：渐变加少量噪声，各后端都能压缩
+std::vector<u8> make_bmp() {
+    const u32 width = 2048, height = 2048;
+    const u32 row = width * 3;
+    std::vector<u8> data(54 + static_cast<size_t>(row) * height);
+    auto put = [&](size_t offset, u32 value, int bytes) {
+        for (int b = 0; b < bytes; b++) {
+            data[offset + b] = static_cast<u8>(value >> (8 * b));
+        }
+    };
+    data[0] = 'B';
+    data[1] = 'M';
+    put(2, static_cast<u32>(data.size()), 4);
+    put(10, 54, 4);
+    put(14, 40, 4);
+    put(18, width, 4);
+    put(22, height, 4);
+    put(26, 1, 2);
+    put(28, 24, 2);
+    put(34, row * height, 4);
+    std::mt19937 rng(7);
+    for (u32 y = 0; y < height; y++) {
+        for (u32 x = 0; x < width; x++) {
+            size_t p = 54 + static_cast<size_t>(y) * row + x * 3;
+            u32 noise = rng() & 3;
+            data[p] = static_cast<u8>(x / 16 + noise);
+            data[p + 1] = static_cast<u8>(y / 16 + noise);
+            data[p + 2] = static_cast<u8>((x + y) / 32);
+        }
+    }
+    return data;
+}
+
+bool check(const std::string &name, const Usage &usage, size_t max_large, size_t max_peak, size_t max_copied, size_t size) {
+    bool ok = usage.large <= max_large && usage.peak <= max_peak && usage.copied <= max_copied;
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << ": " << usage.large << " large allocations (max " << max_large
+              << "), peak +" << usage.peak * 100 / size << "% of input (max " << max_peak * 100 / size << "%), copied "
+              << usage.copied * 100 / size << "% of input (max " << max_copied * 100 / size << "%)" << std::endl;
+    return ok;
+}
+}
+
+int main() {
+    std::cout << "=== Buffer Budget Test ===" << std::endl;
+    Logger::getInstance().setLogLevel(LogLevel::WARNING);
+    bool ok = true;
+
+    const std::vector<u8> data = make_bmp();
+    const size_t size = data.size();
+    std::vector<u8> out(size);
+
+    const HufCoder coders[] = {HufCoder::HUFFMAN, HufCoder::TANS, HufCoder::RICE, HufCoder::CONTEXT, HufCoder::PIXEL,
+                               HufCoder::BLOCK, HufCoder::PRETRAINED, HufCoder::STORED, HufCoder::SEGMENTED};
+    for (HufCoder coder : coders) {
+        std::string name = "coder " + std::to_string(static_cast<int>(coder));
+        HufOptions options;
+        options.coder = coder;
+
+        // 编码：输入只读，唯一的大缓冲是位集（存储模式下位集即数据本身）。
+        // 各后端直接编码进位集不再复制，只有分段编码把目录插到位流前面时移动一次位集
+        size_t baseline = stats.live;
+        begin(size);
+        std::unique_ptr<huf> hufFile(hufHandler::encodeHuf(data.data(), size, coder, options));
+        size_t max_copied = coder == HufCoder::SEGMENTED ? hufFile->bitset.size() : 0;
+        ok &= check(name + " encode", end(baseline), 1, hufFile->bitset.capacity() + size / 4, max_copied, size);
+
+        // 解码到调用者的内存：不分配大缓冲，也不复制位集
+        baseline = stats.live;
+        begin(size);
+        bmpHandler::decodeHufInto(hufFile.get(), hufFile->bitset.data(), hufFile->bitset_size, out.data(), nullptr);
+        ok &= check(name + " decode into", end(baseline), 0, size / 4, 0, size);
+
+        // 解码到新的vector：结果只分配一次
+        baseline = stats.live;
+        begin(size);
+        std::vector<u8> decoded = bmpHandler::decodeHuf(hufFile.get(), nullptr);
+        Usage usage = end(baseline);
+        ok &= check(name + " decode", usage, 1, size + size / 4, 0, size);
+
+        if (out != data || decoded != data) {
+            std::cout << "[FAIL] " << name << " round trip mismatch" << std::endl;
+            ok = false;
+        }
+    }
+
+    // 文件到文件：压缩时映射输入，解压时映射输出，堆上只有位集
+    const std::string bmp_path = "buffer_budget_input.bmp";
+    const std::string huf_path = "buffer_budget_output.huf";
+    const std::string out_path = "buffer_budget_output.bmp";
+    {
+        std::ofstream file(bmp_path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(data.data()), size);
+    }
+    size_t baseline = stats.live;
+    begin(size);
+    ok &= hufHandler::bmp2huf_start(bmp_path, huf_path, nullptr);
+    // 位集按输入大小一次预留（见encode_reserve），因此峰值以输入大小为界；
+    // 文件头和码表经写缓冲复制，大块的位集直接写出
+    ok &= check("bmp2huf file", end(baseline), 1, size + size / 4, size / 4, size);
+
+    baseline = stats.live;
+    begin(size);
+    ok &= bmpHandler::huf2bmp_start(huf_path, out_path, nullptr);
+    ok &= check("huf2bmp file", end(baseline), 0, size / 4, size / 4, size);
+
+    {
+        std::ifstream file(out_path, std::ios::binary);
+        std::vector<u8> restored((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (restored != data) {
+            std::cout << "[FAIL] file round trip mismatch" << std::endl;
+            ok = false;
+        }
+    }
+
+    // 定长窗口流式转换：堆上只有输入、输出窗口和读写缓冲，峰值是与文件大小无关的常数
+    StreamOptions stream;
+    stream.window = 256u << 10;
+    const size_t stream_budget = 4 * stream.window + (3u << 20);
+    const std::string stream_huf = "buffer_budget_stream.huf";
+    const std::string stream_out = "buffer_budget_stream.bmp";
+    baseline = stats.live;
+    begin(size);
+    ok &= streamConvert::bmp2huf(bmp_path, stream_huf, nullptr, stream);
+    // 窗口小于读写缓冲，数据经缓冲复制：压缩时两遍读入各复制一次输入、写出复制一次位集，
+    // 解压时读入位集和写出结果各复制一次
+    ok &= check("stream bmp2huf", end(baseline), 0, stream_budget, 3 * size, size);
+
+    baseline = stats.live;
+    begin(size);
+    ok &= streamConvert::huf2bmp(stream_huf, stream_out, nullptr, std::string(), stream);
+    ok &= check("stream huf2bmp", end(baseline), 0, stream_budget, 2 * size, size);
+
+    // 流式压缩的输出是普通的静态哈夫曼文件，流式解压也能读取普通压缩的文件
+    ok &= bmpHandler::huf2bmp_start(stream_huf, out_path, nullptr);
+    for (const std::string &path : {stream_out, out_path}) {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<u8> restored((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (restored != data) {
+            std::cout << "[FAIL] stream round trip mismatch: " << path << std::endl;
+            ok = false;
+        }
+    }
+    ok &= streamConvert::huf2bmp(huf_path, stream_out, nullptr, std::string(), stream);
+    {
+        std::ifstream file(stream_out, std::ios::binary);
+        std::vector<u8> restored((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (restored != data) {
+            std::cout << "[FAIL] stream decode of regular file mismatch" << std::endl;
+            ok = false;
+        }
+    }
+
+    std::remove(bmp_path.c_str());
+    std::remove(huf_path.c_str());
+    std::remove(out_path.c_str());
+    std::remove(stream_huf.c_str());
+    std::remove(stream_out.c_str());
+
+    std::cout << (ok ? "=== All buffer budget tests passed ===" : "=== Buffer budget tests FAILED ===") << std::endl;
+    return ok ? 0 : 1;
+}
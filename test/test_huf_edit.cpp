@@ -0,0 +1,158 @@
+#include "task/hufEdit.h"
+#include "task/bmpHandler.h"
+#include "huffman/bmplayout.h"
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// 压缩域编辑往返测试：裁剪、切分、拼接的结果解码后与直接在BMP上操作的结果逐字节相同；
+// 宽度、位深、存储方向或调色板不一致的拼接必须报错，不能越界读取
+
+namespace {
+void put(std::vector<u8> &data, size_t offset, u32 value, int bytes) {
+    for (int b = 0; b < bytes; b++) {
+        data[offset + b] = static_cast<u8>(value >> (8 * b));
+    }
+}
+
+// height为负数时自上而下存储；位深不超过8时带调色板，palette_seed区分不同的调色板
+std::vector<u8> make_bmp(u32 width, int height, u32 bit_count, u32 palette_seed = 0) {
+    const u32 rows = static_cast<u32>(height < 0 ? -height : height);
+    const u32 row = (width * bit_count + 31) / 32 * 4;
+    const u32 palette = bit_count <= 8 ? 4u << bit_count : 0;
+    const u32 offset = 54 + palette;
+    std::vector<u8> data(offset + static_cast<size_t>(row) * rows);
+    data[0] = 'B';
+    data[1] = 'M';
+    put(data, 2, static_cast<u32>(data.size()), 4);
+    put(data, 10, offset, 4);
+    put(data, 14, 40, 4);
+    put(data, 18, width, 4);
+    put(data, 22, static_cast<u32>(height), 4);
+    put(data, 26, 1, 2);
+    put(data, 28, bit_count, 2);
+    put(data, 34, row * rows, 4);
+    for (u32 i = 0; i < palette; i++) {
+        data[54 + i] = static_cast<u8>(i * 7 + palette_seed);
+    }
+    std::mt19937 rng(bit_count * 31 + rows);
+    for (u32 y = 0; y < rows; y++) {
+        for (u32 x = 0; x < row; x++) {
+            data[offset + static_cast<size_t>(y) * row + x] = static_cast<u8>((x / 8 + y / 4) * 3 + (rng() & 1));
+        }
+    }
+    return data;
+}
+
+// 直接在BMP上取出按显示顺序从first开始的count行
+std::vector<u8> expect_rows(const std::vector<u8> &bmp, u64 first, u64 count) {
+    BmpLayout layout = BmpLayout::parse(bmp.data(), bmp.size());
+    u64 rows = static_cast<u64>(layout.height < 0 ? -layout.height : layout.height);
+    u64 stored_first = layout.height > 0 ? rows - first - count : first;
+    std::vector<u8> result(bmp.begin(), bmp.begin() + layout.offset);
+    result.insert(result.end(), bmp.begin() + layout.offset + stored_first * layout.row_bytes,
+                  bmp.begin() + layout.offset + (stored_first + count) * layout.row_bytes);
+    put(result, 2, static_cast<u32>(result.size()), 4);
+    put(result, 22, static_cast<u32>(layout.height < 0 ? -static_cast<long long>(count) : static_cast<long long>(count)), 4);
+    put(result, 34, static_cast<u32>(count * layout.row_bytes), 4);
+    return result;
+}
+
+huf *encode(const std::vector<u8> &bmp, HufCoder coder) {
+    HufOptions options;
+    options.coder = coder;
+    return hufHandler::encodeHuf(bmp.data(), bmp.size(), coder, options);
+}
+
+bool report(const std::string &name, bool ok) {
+    if (!ok) {
+        std::cout << "[FAIL] " << name << std::endl;
+    }
+    return ok;
+}
+
+bool round_trip(const std::string &name, const std::vector<u8> &bmp, HufCoder coder) {
+    bool ok = true;
+    try {
+        std::unique_ptr<huf> hufFile(encode(bmp, coder));
+        BmpLayout layout = BmpLayout::parse(bmp.data(), bmp.size());
+        u32 rows = static_cast<u32>(layout.height < 0 ? -layout.height : layout.height);
+
+        const u32 crops[][2] = {{0, 1}, {rows / 3, rows / 2}, {rows - 1, 1}, {0, rows}};
+        for (const auto &crop : crops) {
+            std::unique_ptr<huf> result(hufEdit::crop(hufFile.get(), crop[0], crop[1]));
+            ok &= report(name + " crop " + std::to_string(crop[0]) + "+" + std::to_string(crop[1]),
+                         bmpHandler::decodeHuf(result.get(), nullptr) == expect_rows(bmp, crop[0], crop[1]));
+        }
+
+        u32 rows_per_part = rows / 4 + 1;
+        std::vector<huf *> parts = hufEdit::split(hufFile.get(), rows_per_part);
+        std::vector<std::unique_ptr<huf>> owned(parts.begin(), parts.end());
+        for (size_t k = 0; k < parts.size(); k++) {
+            u32 first = static_cast<u32>(k) * rows_per_part;
+            ok &= report(name + " split " + std::to_string(k),
+                         bmpHandler::decodeHuf(parts[k], nullptr) ==
+                             expect_rows(bmp, first, std::min(rows_per_part, rows - first)));
+        }
+
+        // 拼回原图，再裁剪一次已是分段编码的结果
+        std::unique_ptr<huf> joined(hufEdit::concat(std::vector<const huf *>(parts.begin(), parts.end())));
+        ok &= report(name + " concat", bmpHandler::decodeHuf(joined.get(), nullptr) == expect_rows(bmp, 0, rows));
+        std::unique_ptr<huf> again(hufEdit::crop(joined.get(), rows / 3, rows / 2));
+        ok &= report(name + " recrop", bmpHandler::decodeHuf(again.get(), nullptr) == expect_rows(bmp, rows / 3, rows / 2));
+    } catch (const std::exception &e) {
+        std::cout << "[FAIL] " << name << ": " << e.what() << std::endl;
+        return false;
+    }
+    if (ok) {
+        std::cout << "[PASS] " << name << std::endl;
+    }
+    return ok;
+}
+
+bool rejected(const std::string &name, const std::vector<u8> &first, const std::vector<u8> &second) {
+    std::unique_ptr<huf> a(encode(first, HufCoder::HUFFMAN));
+    std::unique_ptr<huf> b(encode(second, HufCoder::HUFFMAN));
+    try {
+        std::unique_ptr<huf> joined(hufEdit::concat({a.get(), b.get()}));
+    } catch (const std::exception &e) {
+        bool ok = std::string(e.what()) == "Incompatible images";
+        std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << " rejected: " << e.what() << std::endl;
+        return ok;
+    }
+    std::cout << "[FAIL] " << name << " accepted" << std::endl;
+    return false;
+}
+}
+
+int main() {
+    std::cout << "=== HUF Edit Round Trip Test ===" << std::endl;
+    Logger::getInstance().setLogLevel(LogLevel::ERROR);
+    bool ok = true;
+
+    const HufCoder coders[] = {HufCoder::HUFFMAN, HufCoder::TANS, HufCoder::CONTEXT,
+                               HufCoder::PIXEL, HufCoder::STORED, HufCoder::SEGMENTED};
+    const u32 depths[] = {24, 8, 1};
+    for (HufCoder coder : coders) {
+        for (u32 bit_count : depths) {
+            for (int direction : {1, -1}) {
+                std::string name = "coder " + std::to_string(static_cast<int>(coder)) + " " + std::to_string(bit_count) +
+                                   "bpp " + (direction > 0 ? "bottom-up" : "top-down");
+                ok &= round_trip(name, make_bmp(37, direction * 23, bit_count), coder);
+            }
+        }
+    }
+
+    // 文件头较短的部分在后：比较调色板前必须先比较文件头长度
+    ok &= rejected("8bpp + 24bpp", make_bmp(37, 23, 8), make_bmp(37, 23, 24));
+    ok &= rejected("24bpp + 8bpp", make_bmp(37, 23, 24), make_bmp(37, 23, 8));
+    ok &= rejected("8bpp + 1bpp", make_bmp(37, 23, 8), make_bmp(37, 23, 1));
+    ok &= rejected("width", make_bmp(37, 23, 24), make_bmp(38, 23, 24));
+    ok &= rejected("row order", make_bmp(37, 23, 24), make_bmp(37, -23, 24));
+    ok &= rejected("palette", make_bmp(37, 23, 8), make_bmp(37, 23, 8, 1));
+
+    std::cout << (ok ? "=== All HUF edit tests passed ===" : "=== HUF edit tests FAILED ===") << std::endl;
+    return ok ? 0 : 1;
+}
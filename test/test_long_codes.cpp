@@ -0,0 +1,130 @@
+#include "task/hufHandler.h"
+#include "task/bmpHandler.h"
+#include "task/streamConvert.h"
+#include "huffman/huffmantree.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// 长码测试：按字节编码不限制码长，频数按斐波那契数增长时码长超过32位，
+// 解码必须能读出这样的文件（包括码长限制之前写出的旧文件）
+
+namespace {
+// 第k个符号出现F(k)次，哈夫曼树退化为一条链，最长码长为COUNT-1
+const int COUNT = 34;
+
+std::vector<u8> make_data() {
+    std::vector<u8> data;
+    u64 a = 1, b = 1;
+    for (int k = 0; k < COUNT; k++) {
+        data.insert(data.end(), a, static_cast<u8>(k == COUNT - 1 ? 0 : 150 + k));
+        u64 next = a + b;
+        a = b;
+        b = next;
+    }
+    std::shuffle(data.begin(), data.end(), std::mt19937_64(1));
+    return data;
+}
+
+int longest_code(const std::vector<u8> &data) {
+    HuffmanTree<u8> tree;
+    std::vector<u64> histogram(256, 0);
+    for (u8 byte : data) {
+        histogram[byte]++;
+    }
+    std::unordered_map<u8, u64> frequency_map;
+    for (int s = 0; s < 256; s++) {
+        if (histogram[s] > 0) {
+            frequency_map[static_cast<u8>(s)] = histogram[s];
+        }
+    }
+    tree.input_data(frequency_map);
+    tree.spawnTree();
+    int longest = 0;
+    for (auto &code : tree.get_code_map()) {
+        longest = std::max<int>(longest, code.second.second);
+    }
+    return longest;
+}
+
+std::vector<u8> read_file(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<u8>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+bool report(const std::string &name, bool ok) {
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << std::endl;
+    return ok;
+}
+
+template <typename F>
+bool attempt(const std::string &name, F body) {
+    try {
+        return report(name, body());
+    } catch (const std::exception &e) {
+        std::cout << "[FAIL] " << name << ": " << e.what() << std::endl;
+        return false;
+    }
+}
+}
+
+int main() {
+    std::cout << "=== Long Code Test ===" << std::endl;
+    Logger::getInstance().setLogLevel(LogLevel::WARNING);
+    bool ok = true;
+
+    const std::vector<u8> data = make_data();
+    int longest = longest_code(data);
+    ok &= report("longest code " + std::to_string(longest) + " bits", longest > 32);
+
+    // 分段编码与静态哈夫曼使用同样的码表，同样不限制码长
+    for (HufCoder coder : {HufCoder::HUFFMAN, HufCoder::SEGMENTED}) {
+        ok &= attempt("coder " + std::to_string(static_cast<int>(coder)) + " memory round trip", [&]() {
+            HufOptions options;
+            options.coder = coder;
+            options.symbol_bits = 8;
+            std::unique_ptr<huf> hufFile(hufHandler::encodeHuf(data.data(), data.size(), coder, options));
+            return bmpHandler::decodeHuf(hufFile.get(), nullptr) == data;
+        });
+    }
+
+    const std::string bmp_path = "long_codes_input.bmp";
+    const std::string huf_path = "long_codes_output.huf";
+    const std::string out_path = "long_codes_output.bmp";
+    {
+        std::ofstream file(bmp_path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(data.data()), data.size());
+    }
+    ok &= attempt("file round trip", [&]() {
+        return hufHandler::bmp2huf_start(bmp_path, huf_path, nullptr) &&
+               bmpHandler::huf2bmp_start(huf_path, out_path, nullptr) && read_file(out_path) == data;
+    });
+    // 校验与解码结论一致：能解码的文件校验通过
+    ok &= attempt("validate", [&]() { return bmpHandler::validateHuf(huf_path); });
+
+    // 流式解压逐窗口衔接，长码可能跨越窗口边界
+    const std::string stream_huf = "long_codes_stream.huf";
+    StreamOptions stream;
+    stream.window = streamConvert::MIN_WINDOW;
+    ok &= attempt("stream decode", [&]() {
+        return streamConvert::huf2bmp(huf_path, out_path, nullptr, std::string(), stream) && read_file(out_path) == data;
+    });
+    ok &= attempt("stream round trip", [&]() {
+        return streamConvert::bmp2huf(bmp_path, stream_huf, nullptr, stream) &&
+               streamConvert::huf2bmp(stream_huf, out_path, nullptr, std::string(), stream) && read_file(out_path) == data;
+    });
+    ok &= attempt("validate stream output", [&]() { return bmpHandler::validateHuf(stream_huf); });
+
+    std::remove(bmp_path.c_str());
+    std::remove(huf_path.c_str());
+    std::remove(out_path.c_str());
+    std::remove(stream_huf.c_str());
+
+    std::cout << (ok ? "=== All long code tests passed ===" : "=== Long code tests FAILED ===") << std::endl;
+    return ok ? 0 : 1;
+}
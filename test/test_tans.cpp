@@ -0,0 +1,64 @@
+#include "huffman/huffmantree.h"
+#include "huffman/tans.h"
+#include <iostream>
+#include <vector>
+#include <random>
+
+// tANS编解码往返测试：偏斜分布、单符号、空数据
+static bool roundTrip(const std::string &name, const std::vector<u8> &data) {
+    HuffmanTree<u8> tree;
+    for (u8 byte : data) {
+        tree.input_data(byte);
+    }
+    if (!data.empty()) {
+        tree.spawnTree();
+    }
+
+    TansCoder encoder(tree.get_frequency_map());
+    std::vector<u8> encoded = encoder.encode(data);
+
+    // 解码端只拿到频数表和表大小
+    TansCoder decoder(tree.get_frequency_map(), encoder.get_table_log());
+    std::vector<u8> decoded = decoder.decode(encoded, data.size());
+
+    bool ok = decoded == data;
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << ": " << data.size() << " -> "
+              << encoded.size() << " bytes (table log " << static_cast<int>(encoder.get_table_log()) << ")"
+              << std::endl;
+    return ok;
+}
+
+int main() {
+    std::cout << "=== tANS Round Trip Test ===" << std::endl;
+    bool ok = true;
+
+    std::mt19937 rng(42);
+    std::geometric_distribution<int> geometric(0.35);
+    std::vector<u8> skewed(200000);
+    for (auto &byte : skewed) {
+        byte = static_cast<u8>(std::min(geometric(rng), 255));
+    }
+    ok &= roundTrip("skewed", skewed);
+
+    std::vector<u8> uniform(50000);
+    for (auto &byte : uniform) {
+        byte = static_cast<u8>(rng());
+    }
+    ok &= roundTrip("uniform", uniform);
+
+    ok &= roundTrip("single symbol", std::vector<u8>(1000, 7));
+    ok &= roundTrip("one byte", std::vector<u8>(1, 200));
+
+    // 损坏的位流必须抛出异常而不是越界读取
+    try {
+        TansCoder coder({{1, 10}, {2, 5}});
+        coder.decode(std::vector<u8>{0x00}, 10);
+        std::cout << "[FAIL] corrupt stream accepted" << std::endl;
+        ok = false;
+    } catch (const std::exception &e) {
+        std::cout << "[PASS] corrupt stream rejected: " << e.what() << std::endl;
+    }
+
+    std::cout << (ok ? "=== All tANS tests passed ===" : "=== tANS tests FAILED ===") << std::endl;
+    return ok ? 0 : 1;
+}
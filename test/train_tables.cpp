@@ -0,0 +1,73 @@
+#include "huffman/pretrained.h"
+#include "task/bmpHandler.h"
+#include "logger/Logger.h"
+#include <iomanip>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+// 预训练码表训练工具
+//   train_tables dict <字典文件> <编号> <样本.bmp...>   训练一张表并写入（或替换）字典文件中的该编号
+//   train_tables header <样本组名> <样本.bmp...>        输出可粘贴进pretraineddefaults.h的constexpr数组
+static void usage() {
+    std::cout << "用法:\n"
+              << "  train_tables dict <字典文件> <编号(" << static_cast<int>(PretrainedTables::FIRST_DICTIONARY_ID)
+              << "-254)> <样本.bmp...>\n"
+              << "  train_tables header <样本组名> <样本.bmp...>\n";
+}
+
+static std::vector<std::vector<u8>> loadSamples(int argc, char *argv[], int first) {
+    std::vector<std::vector<u8>> samples;
+    for (int i = first; i < argc; i++) {
+        bmp *bmpFile = bmpHandler::load(argv[i]);
+        samples.push_back(std::move(bmpFile->filemap));
+        delete bmpFile;
+    }
+    return samples;
+}
+
+int main(int argc, char *argv[]) {
+    // header模式的输出要直接粘贴进源码，日志只保留警告和错误
+    Logger::getInstance().setLogLevel(LogLevel::WARNING);
+    if (argc < 4) {
+        usage();
+        return 1;
+    }
+    std::string command = argv[1];
+
+    if (command == "dict" && argc >= 5) {
+        std::string dictionary = argv[2];
+        int id = std::stoi(argv[3]);
+        if (id < PretrainedTables::FIRST_DICTIONARY_ID || id >= PretrainedTables::AUTO_ID) {
+            usage();
+            return 1;
+        }
+        std::map<u8, std::vector<u16>> tables;
+        if (std::ifstream(dictionary).good()) {
+            tables = PretrainedTables::loadDictionary(dictionary);
+        }
+        tables[static_cast<u8>(id)] = PretrainedTables::train(loadSamples(argc, argv, 4));
+        if (!PretrainedTables::saveDictionary(dictionary, tables)) {
+            std::cerr << "保存字典失败: " << dictionary << std::endl;
+            return 1;
+        }
+        std::cout << "已写入码表 " << id << "，字典共 " << tables.size() << " 张表" << std::endl;
+        return 0;
+    }
+
+    if (command == "header") {
+        std::vector<u16> table = PretrainedTables::train(loadSamples(argc, argv, 3));
+        std::cout << "    // " << argv[2] << "\n    {";
+        for (u32 s = 0; s < 256; s++) {
+            if (s % 16 == 0) {
+                std::cout << "\n        ";
+            }
+            std::cout << table[s] << (s + 1 < 256 ? "," : "") << ((s + 1) % 16 != 0 ? " " : "");
+        }
+        std::cout << "\n    }," << std::endl;
+        return 0;
+    }
+
+    usage();
+    return 1;
+}